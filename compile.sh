@@ -1,3 +1,5 @@
 #!/bin/bash
 
-gcc -Wall -Wextra minishell.c libparser.a -o minishell -static
\ No newline at end of file
+gcc -Wall -Wextra -pthread -c libminishell.c -o libminishell.o
+ar rcs libminishell.a libminishell.o
+gcc -Wall -Wextra -pthread minishell.c libminishell.a libparser.a -o minishell -ldl
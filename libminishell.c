@@ -0,0 +1,11036 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <poll.h>
+#include <time.h>
+#include <dlfcn.h>
+#include <stdio_ext.h>
+#include <mntent.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/signalfd.h>
+
+#include "parser.h"
+#include "minishell.h"
+
+/**
+ * Maximum number of characters per input line. Adjusting this value allows
+ * controlling the maximum length of input lines.
+ */
+#define MAXIMUM_LINE_LENGTH MSH_MAXIMUM_LINE_LENGTH
+
+/**
+ * Result code for the child process in a fork operation.
+ */
+#define FORK_CHILD 0
+
+/**
+ * Argument to the `exit()` function to indicate that the program encountered
+ * an error or failure during execution signaling to the operating system that
+ * an issue occurred.
+ */
+#define EXIT_FAILURE 1
+
+/**
+ * Flags for opening a file when reading. These flags are used in `open()` to
+ * specify read-only access to the file.
+ */
+#define FILE_READ O_RDONLY
+
+/**
+ * Flags for opening a file when writing. These flags are used in `open()` to
+ * specify write-only access to the file, creating or truncating it.
+ */
+#define FILE_WRITE (O_WRONLY | O_CREAT | O_TRUNC)
+
+/**
+ * Permissions of the files created by output redirections, before applying
+ * the file creation mask.
+ */
+#define FILE_PERMISSIONS 0666
+
+/**
+ * Value of a file descriptor that is not open.
+ */
+#define NO_FILE -1
+
+/**
+ * Pipe in file descriptors array.
+ */
+#define PIPE 2
+
+/**
+ * Read end of a pipe.
+ */
+#define PIPE_READ 0
+
+/**
+ * Write end of a pipe.
+ */
+#define PIPE_WRITE 1
+
+/**
+ * Environment variable representing the user's home directory.
+ */
+#define HOME "HOME"
+
+/**
+ * Index representing the command part of an argument array.
+ */
+#define COMMAND 0
+
+/**
+ * Index representing the directory part of an argument array.
+ */
+#define DIRECTORY 1
+
+/**
+ * Default Unix mask value for file permissions.
+ *
+ * Represent the default Unix mask value for file permissions. It is set to 18
+ * in octal, which corresponds to 022 in decimal.
+ */
+#define DEFAULT_UNIX_MASK 18
+
+/**
+ * Default Unix formatted mask value for file permissions which is used for
+ * display purposes.
+ */
+#define DEFAULT_UNIX_FORMATTED_MASK 22;
+
+/**
+ * Index representing the mask part of an argument array.
+ */
+#define MASK 1
+
+/**
+ * Define the maximum number of processes a job can have.
+ */
+#define MAXIMUM_PID_LIST_SIZE MSH_MAXIMUM_COMMANDS
+
+/**
+ * Maximum size allowed for the list of active jobs in the shell.
+ */
+#define MAXIMUM_JOB_LIST_SIZE 50
+
+/**
+ * Signal number used for the kill system call to forcefully terminate a
+ * process.
+ */
+#define KILL 9
+
+/**
+ * Index representing the job part of an argument array.
+ */
+#define JOB 1
+
+/**
+ * Wait for the specified child process. It is used as the options
+ * argument in the `waitpid` function.
+ *
+ * Example usage:
+ * ```c
+ * waitpid(pid, NULL, WAIT);
+ * ```
+ */
+#define WAIT 0
+
+/**
+ * File descriptor of the terminal whose foreground process group is handed
+ * to the jobs executed in foreground.
+ */
+#define TERMINAL STDIN_FILENO
+
+/**
+ * Character prefixing a job number in the arguments of `fg`, `bg` and
+ * `kill`, as in `kill %1`.
+ */
+#define JOB_PREFIX '%'
+
+/**
+ * Shell variable holding the number of milliseconds `exit` waits for the
+ * jobs to finish after sending them `SIGTERM`, before killing them.
+ */
+#define EXIT_TIMEOUT "MSH_EXIT_TIMEOUT"
+
+/**
+ * Default number of milliseconds `exit` waits for the jobs to finish.
+ */
+#define DEFAULT_EXIT_TIMEOUT 2000
+
+/**
+ * Environment variable enabling the subreaper mode when it is set to a
+ * nonzero number at startup, so orphaned descendants of the jobs are adopted
+ * by the shell instead of `init`.
+ */
+#define SUBREAPER "MSH_SUBREAPER"
+
+/**
+ * Number of milliseconds between checks of the process groups where only
+ * adopted descendants are left while `exit` waits for them, since they have
+ * no process file descriptor to be polled.
+ */
+#define ORPHAN_POLL_INTERVAL 10
+
+/**
+ * Option of `jobs` listing the process group and resource usage of every
+ * job.
+ */
+#define LONG_LISTING "-l"
+
+/**
+ * Environment variable holding the number of zygotes, pre-forked helper
+ * processes that execute commands on request so the shell does not fork on
+ * the critical path. Zygotes are disabled if it is not set or zero.
+ */
+#define ZYGOTES "MSH_ZYGOTES"
+
+/**
+ * Upper bound on the number of zygotes kept ready.
+ */
+#define MAXIMUM_ZYGOTES 64
+
+/**
+ * Number of zygotes used by `benchmark` when they are disabled.
+ */
+#define DEFAULT_ZYGOTES 4
+
+/**
+ * Number of standard file descriptors handed to a zygote.
+ */
+#define STANDARD_FILES 3
+
+/**
+ * Number of file descriptors handed to a zygote: the standard ones and the
+ * working directory of the shell.
+ */
+#define ZYGOTE_FILES (STANDARD_FILES + 1)
+
+/**
+ * Number of bytes of the status message sent back for each request.
+ */
+#define RESPONSE_SIZE 256
+
+/**
+ * Message sent to a client once connected, along with the pipe carrying the
+ * output of its commands.
+ */
+#define OUTPUT_GREETING "output\n"
+
+/**
+ * Milliseconds the server waits before accepting clients again once it ran
+ * out of file descriptors or memory.
+ */
+#define ACCEPT_RETRY_INTERVAL 100
+
+/**
+ * Number of the `pidfd_open` system call, for C libraries that do not
+ * define it yet.
+ */
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+/**
+ * Maximum number of builtins loaded from shared objects with `enable -f`.
+ */
+#define MAXIMUM_BUILTINS 64
+
+/**
+ * Suffix appended to the name of a loadable builtin to get the symbol of its
+ * handler in the shared object.
+ */
+#define BUILTIN_SUFFIX "_builtin"
+
+/**
+ * Option of `enable` loading builtins from a shared object.
+ */
+#define LOAD "-f"
+
+/**
+ * Option of `enable` removing loaded builtins.
+ */
+#define REMOVE "-d"
+
+/**
+ * Index of the option in the arguments of `enable`.
+ */
+#define OPTION 1
+
+/**
+ * Index of the shared object in the arguments of `enable -f`.
+ */
+#define LIBRARY 2
+
+/**
+ * Index of the first builtin name in the arguments of `enable -f`.
+ */
+#define NAMES 3
+
+/**
+ * Options of `ulimit` naming every resource, in the order `ulimit -a`
+ * displays them.
+ */
+#define RESOURCES "cdefilmnqrstuvxR"
+
+/**
+ * Maximum number of limits given to a single `ulimit` or `limit`, one per
+ * resource.
+ */
+#define MAXIMUM_LIMITS 16
+
+/**
+ * Environment variable enabling a cgroup for every job when set to a nonzero
+ * number.
+ */
+#define CGROUPS "MSH_CGROUPS"
+
+/**
+ * File listing the mounted file systems, searched for the cgroup v2
+ * hierarchy.
+ */
+#define MOUNTS "/proc/self/mounts"
+
+/**
+ * Type of the file system of the cgroup v2 hierarchy.
+ */
+#define CGROUP_FILESYSTEM "cgroup2"
+
+/**
+ * File holding the cgroups of the shell.
+ */
+#define OWN_CGROUP "/proc/self/cgroup"
+
+/**
+ * Name of the cgroup the shell moves to, beside the cgroups of its jobs.
+ */
+#define SHELL_CGROUP "shell"
+
+/**
+ * Format of the name of the cgroup of a job.
+ */
+#define JOB_CGROUP "job-%i"
+
+/**
+ * Maximum length of the name of the cgroup of a job.
+ */
+#define CGROUP_NAME_LENGTH 32
+
+/**
+ * Permissions of the cgroups created by the shell.
+ */
+#define CGROUP_PERMISSIONS 0755
+
+/**
+ * Size of the buffer used to read and write the files of a cgroup.
+ */
+#define CGROUP_BUFFER_SIZE 1024
+
+/**
+ * Period of `cpu.max`, in microseconds, over which the quota of a job is
+ * given.
+ */
+#define CPU_PERIOD 100000
+
+/**
+ * Number of the `clone3` system call and flag creating the child inside a
+ * cgroup, for C libraries that do not define them yet.
+ */
+#ifndef SYS_clone3
+#define SYS_clone3 435
+#endif
+
+#ifndef CLONE_INTO_CGROUP
+#define CLONE_INTO_CGROUP 0x200000000ULL
+#endif
+
+/**
+ * Placements of the commands of a job given to `pin`: none, lists of
+ * processors, spread over the NUMA nodes, or packed in a group of processors
+ * sharing a level 3 cache.
+ */
+#define PIN_NONE 0
+#define PIN_CPUS 1
+#define PIN_AUTO 2
+#define PIN_L3 3
+
+/**
+ * Index of the placement in the arguments of the `pin` prefix.
+ */
+#define PLACEMENT 1
+
+/**
+ * Character separating the processors of the commands of a pipeline given to
+ * `pin`.
+ */
+#define STAGE_SEPARATOR ':'
+
+/**
+ * Directory holding the NUMA nodes of the machine.
+ */
+#define NODES "/sys/devices/system/node"
+
+/**
+ * Directory holding the processors of the machine.
+ */
+#define CPUS "/sys/devices/system/cpu"
+
+/**
+ * File listing the processors online.
+ */
+#define ONLINE_CPUS "/sys/devices/system/cpu/online"
+
+/**
+ * Maximum number of NUMA nodes or groups of processors sharing a cache.
+ */
+#define MAXIMUM_DOMAINS 64
+
+/**
+ * Maximum number of caches of a processor searched for the level 3 one.
+ */
+#define MAXIMUM_CACHES 10
+
+/**
+ * Level of the cache shared by the commands of a job placed with `pin l3`.
+ */
+#define CACHE_LEVEL 3
+
+/**
+ * Size of the buffer used to read a list of processors.
+ */
+#define CPU_LIST_SIZE 4096
+
+/**
+ * Bytes of the argument space of `execve()` left unused when splitting the
+ * arguments of a command into batches, like `xargs` does.
+ */
+#define ARGUMENT_HEADROOM 2048
+
+/**
+ * Number of pages of the longest single argument accepted by `execve()`,
+ * `MAX_ARG_STRLEN` in Linux.
+ */
+#define ARGUMENT_PAGES 32
+
+/**
+ * Maximum number of batches of a command run at once by `batch -j`.
+ */
+#define MAXIMUM_BATCHES 64
+
+/**
+ * Operator running the command following it in several instances, such as
+ * `|||4` in `zcat log.gz |||4 grep ERROR | sort`.
+ */
+#define PARALLEL_OPERATOR "|||"
+
+/**
+ * Maximum number of instances of a command of a pipeline.
+ */
+#define MAXIMUM_INSTANCES 64
+
+/**
+ * Ways the records read by a parallel command are distributed among its
+ * instances: in turns to the first idle instance, by the hash of their first
+ * field, or in chunks to a new instance each whose outputs keep the order of
+ * the input.
+ */
+#define SPLIT_ROUND_ROBIN 0
+#define SPLIT_HASH 1
+#define SPLIT_ORDERED 2
+
+/**
+ * Letters following the number of instances to choose how records are
+ * distributed.
+ */
+#define HASH_SUFFIX 'h'
+#define ORDERED_SUFFIX 'k'
+
+/**
+ * Number of bytes read at once from the input of a parallel command, and
+ * written at most to an instance in a single turn.
+ */
+#define RECORD_BLOCK 65536
+
+/**
+ * Number of bytes of records given to each instance of a parallel command
+ * whose outputs keep the order of the input.
+ */
+#define ORDERED_CHUNK (16 * RECORD_BLOCK)
+
+/**
+ * Number of bytes of output kept for an instance of a parallel command whose
+ * outputs keep the order of the input, while it waits for the previous
+ * ones. Its output is not read beyond that, so the instance blocks instead.
+ */
+#define ORDERED_BACKLOG (16 * RECORD_BLOCK)
+
+/**
+ * Operator sending the output of a pipeline to several branches, such as in
+ * `zcat log.gz |{ grep ERROR > errors ; wc -l } | paste - -`, which the
+ * closing brace ends.
+ */
+#define FAN_OUT "|{"
+
+/**
+ * Character separating the branches of a fan-out.
+ */
+#define BRANCH_SEPARATOR ';'
+
+/**
+ * Command standing for the branches of a fan-out in the pipeline given to
+ * the parser.
+ */
+#define BRANCHES_STAGE "{}"
+
+/**
+ * Maximum number of branches of a fan-out.
+ */
+#define MAXIMUM_BRANCHES 16
+
+/**
+ * Name of the command running another one once per item, handled by the
+ * child of its stage rather than by a program.
+ */
+#define PARALLEL "parallel"
+
+/**
+ * Argument of `parallel` separating the command from its items, which are
+ * otherwise the lines of its input.
+ */
+#define ITEMS_SEPARATOR ":::"
+
+/**
+ * Word of the command of `parallel` replaced by each item.
+ */
+#define ITEM_PLACEHOLDER "{}"
+
+/**
+ * Maximum number of commands `parallel` runs at once.
+ */
+#define MAXIMUM_PARALLEL_JOBS 256
+
+/**
+ * Index of the process file descriptor among the descriptors of a task of
+ * `parallel`, followed by its standard output and error.
+ */
+#define TASK_PROCESS 0
+
+/**
+ * Environment variable holding the number of submitted commands run at once,
+ * which otherwise follows the processors left idle by the load average.
+ */
+#define QUEUE_SLOTS "MSH_QUEUE_SLOTS"
+
+/**
+ * States of a command given to `submit`.
+ */
+#define SUBMISSION_PENDING 0
+#define SUBMISSION_RUNNING 1
+#define SUBMISSION_DONE 2
+
+/**
+ * Offset basis and prime of the FNV-1a hash, used for the names of variables
+ * and the keys of records.
+ */
+#define FNV_OFFSET 2166136261u
+#define FNV_PRIME 16777619u
+
+/**
+ * Environment variable holding the policy that lowers the priority of
+ * background jobs.
+ */
+#define BACKGROUND "MSH_BACKGROUND"
+
+/**
+ * Value of the settings of a background policy that are not given.
+ */
+#define NO_POLICY -1
+
+/**
+ * Level of the best-effort I/O class when the policy does not give one.
+ */
+#define DEFAULT_IO_LEVEL 7
+
+/**
+ * Index of the priority in the arguments of `renice`.
+ */
+#define PRIORITY 1
+
+/**
+ * Number of the `ioprio_set` system call and the values it takes, which the
+ * C library does not declare.
+ */
+#ifndef SYS_ioprio_set
+#define SYS_ioprio_set 251
+#endif
+
+#define IOPRIO_WHO_PROCESS 1
+#define IOPRIO_CLASS_BE 2
+#define IOPRIO_CLASS_IDLE 3
+#define IOPRIO_CLASS_SHIFT 13
+#define IOPRIO_VALUE(class, level) (((class) << IOPRIO_CLASS_SHIFT) | (level))
+
+/**
+ * Environment variable holding the maximum number of commands running at
+ * once, beyond which starting a command waits for another one to finish.
+ */
+#define MAXIMUM_CHILDREN "MSH_MAXIMUM_CHILDREN"
+
+/**
+ * Number of times a child is created while the system is out of processes
+ * or memory before giving up.
+ */
+#define SPAWN_ATTEMPTS 10
+
+/**
+ * Nanoseconds waited after the first failed attempt to create a child,
+ * doubled after every other failure.
+ */
+#define SPAWN_BACKOFF 1000000L
+
+/**
+ * Number of nanoseconds of a second.
+ */
+#define NANOSECONDS 1000000000L
+
+/**
+ * Environment variable holding the number of threads used to walk directory
+ * trees in parallel when expanding recursive `**` patterns.
+ */
+#define GLOB_THREADS "MSH_GLOB_THREADS"
+
+/**
+ * Default number of threads used by the glob engine. A single thread keeps
+ * the walk sequential, which is the fastest option for small trees.
+ */
+#define DEFAULT_GLOB_THREADS 1
+
+/**
+ * Upper bound on the threads the glob engine will start for a single walk.
+ */
+#define MAXIMUM_GLOB_THREADS 64
+
+/**
+ * Size in bytes of the buffer handed to `getdents64`. Large enough to read a
+ * typical directory in one or two system calls.
+ */
+#define DIRECTORY_BUFFER_SIZE 32768
+
+/**
+ * Initial capacity of the arrays that grow while expanding words.
+ */
+#define INITIAL_CAPACITY 16
+
+/**
+ * Bucket size under which the radix sort falls back to insertion sort.
+ */
+#define RADIX_SORT_THRESHOLD 32
+
+/**
+ * Initial number of slots of the shell variables hash table. It must be a
+ * power of two so the probe sequence can be computed with a mask.
+ */
+#define INITIAL_VARIABLES_CAPACITY 64
+
+/**
+ * Character separating the name and the value of a variable assignment.
+ */
+#define ASSIGNMENT '='
+
+/**
+ * Keep the export flag of a variable unchanged when setting its value.
+ */
+#define KEEP_EXPORT -1
+
+/**
+ * Number of bytes read at once from the output of a command substitution.
+ */
+#define READ_SIZE 4096
+
+/**
+ * Type of a list node holding a single pipeline.
+ */
+#define NODE_PIPELINE 0
+
+/**
+ * Type of a list node running its right side only if its left side
+ * succeeded (`&&`).
+ */
+#define NODE_AND 1
+
+/**
+ * Type of a list node running its right side only if its left side failed
+ * (`||`).
+ */
+#define NODE_OR 2
+
+/**
+ * Type of a list node running its left and right sides one after the other
+ * (`;` or `&`).
+ */
+#define NODE_SEQUENCE 3
+
+/**
+ * Exit status offset of commands terminated by a signal, which report the
+ * status `SIGNAL_STATUS + signal number` like in `sh`.
+ */
+#define SIGNAL_STATUS 128
+
+/**
+ * Exit status of a command that could not be executed because it was not
+ * found, like in `sh`.
+ */
+#define COMMAND_NOT_FOUND 127
+
+/**
+ * Exit status of a command that was found but could not be executed, like
+ * in `sh`.
+ */
+#define CANNOT_EXECUTE 126
+
+/**
+ * Exit status of a command line whose commands could not all be started
+ * because no more processes could be created, like in `bash`.
+ */
+#define SPAWN_FAILURE 126
+
+/**
+ * Name of the variable holding the exit status of the last pipeline.
+ */
+#define STATUS "?"
+
+/**
+ * Name of the variable holding the exit status of every command of the last
+ * pipeline, separated by spaces.
+ */
+#define PIPESTATUS "PIPESTATUS"
+
+/**
+ * Directory entry as returned by the `getdents64` system call.
+ */
+struct linux_dirent64
+{
+    ino64_t d_ino;
+    off64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+/**
+ * Structure representing a process of a job.
+ *
+ * Fields:
+ *   - pid: The process identifier.
+ *   - reaped: Flag indicating whether the process has been waited for.
+ *   - status: The status returned by `wait4()`, once reaped.
+ *   - usage: The resources used by the process, once reaped.
+ */
+typedef struct
+{
+    pid_t pid;
+    int reaped;
+    int status;
+    struct rusage usage;
+} tprocess;
+
+/**
+ * Structure representing a job in the shell.
+ *
+ * Fields:
+ *   - instruction: The instruction associated with the job.
+ *   - size: The number of processes in the job.
+ *   - processes: Array of processes within the job.
+ *   - finished: Flag indicating whether the job has finished.
+ *   - pgid: The process group of the job, whose identifier is the one of its
+ *     first process.
+ *   - stopped: Flag indicating whether the job has been stopped.
+ *   - orphans: The number of adopted descendants reaped in subreaper mode.
+ *   - orphanUsage: The resources used by the adopted descendants.
+ *   - callback: The function called once the job finishes, if it was
+ *     started with `msh_start()`, or NULL.
+ *   - data: The pointer handed to the callback.
+ *   - cgroup: The directory of the cgroup of the job, or `NO_FILE`.
+ *   - cgroupId: The number in the name of the cgroup of the job.
+ *   - placement: The placement given to `pin` for the job, or `PIN_NONE`.
+ *   - domain: The NUMA node or cache group the job was placed on, or -1.
+ *   - pipefail: Flag indicating whether the status of the job is the one of
+ *     its last command that failed, as set by `set -o pipefail` when it
+ *     started.
+ */
+typedef struct
+{
+    char instruction[MAXIMUM_LINE_LENGTH];
+    int size;
+    tprocess processes[MAXIMUM_PID_LIST_SIZE];
+    int finished;
+    pid_t pgid;
+    int stopped;
+    int orphans;
+    struct rusage orphanUsage;
+    msh_callback callback;
+    void *data;
+    int cgroup;
+    int cgroupId;
+    int placement;
+    int domain;
+    int pipefail;
+} tjob;
+
+/**
+ * Structure representing the list of active jobs in the shell.
+ *
+ * Fields:
+ *   - list: Pointer to the array of `tjob` structures.
+ *   - size: The current size of the list (number of active jobs).
+ *   - subreaper: Flag indicating whether the shell is the subreaper of its
+ *     descendants, so a job only finishes once its process group is empty.
+ *   - cgroups: The directory of the cgroup holding the cgroups of the shell
+ *     and its jobs, or `NO_FILE` if cgroups are disabled.
+ *   - cgroupCount: The number of cgroups created for jobs.
+ */
+typedef struct
+{
+    tjob *list;
+    int size;
+    int subreaper;
+    int cgroups;
+    int cgroupCount;
+} tjobs;
+
+/**
+ * Structure representing the arguments of the `clone3` system call, which
+ * older C libraries do not declare.
+ */
+typedef struct
+{
+    unsigned long long flags;
+    unsigned long long pidfd;
+    unsigned long long child_tid;
+    unsigned long long parent_tid;
+    unsigned long long exit_signal;
+    unsigned long long stack;
+    unsigned long long stack_size;
+    unsigned long long tls;
+    unsigned long long set_tid;
+    unsigned long long set_tid_size;
+    unsigned long long cgroup;
+} tcloneargs;
+
+/**
+ * Structure representing a slot of the shell variables hash table.
+ *
+ * Fields:
+ *   - entry: The variable as a `NAME=value` string, ready to be handed to
+ *     `execve()`, or NULL if the slot is empty.
+ *   - nameLength: The length of the name part of `entry`.
+ *   - hash: The hash of the name, kept to skip comparisons while probing.
+ *   - exported: Flag indicating whether the variable is exported.
+ *   - deleted: Flag indicating whether the slot held an unset variable, so
+ *     probing must continue past it.
+ */
+typedef struct
+{
+    char *entry;
+    int nameLength;
+    unsigned int hash;
+    int exported;
+    int deleted;
+} tvariable;
+
+/**
+ * Structure representing the shell variables.
+ *
+ * Fields:
+ *   - table: Open addressing hash table of variables.
+ *   - capacity: The number of slots of the table, a power of two.
+ *   - size: The number of variables in the table.
+ *   - deleted: The number of slots holding a deleted marker.
+ *   - environment: The `NULL` terminated array of exported entries handed
+ *     to every `execve()`.
+ *   - environmentCapacity: The number of pointers `environment` can hold.
+ *   - changed: Flag indicating whether the exported variables changed since
+ *     `environment` was last built.
+ */
+typedef struct
+{
+    tvariable *table;
+    int capacity;
+    int size;
+    int deleted;
+    char **environment;
+    int environmentCapacity;
+    int changed;
+} tvariables;
+
+/**
+ * Structure representing the pool of zygotes ready to execute a command.
+ *
+ * Fields:
+ *   - pids: The process identifiers of the zygotes.
+ *   - sockets: The end of the socket connected to each zygote kept by the
+ *     shell.
+ *   - size: The number of zygotes ready.
+ *   - capacity: The number of zygotes the pool is refilled to, 0 if zygotes
+ *     are disabled.
+ */
+typedef struct
+{
+    pid_t pids[MAXIMUM_ZYGOTES];
+    int sockets[MAXIMUM_ZYGOTES];
+    int size;
+    int capacity;
+} tzygotes;
+
+/**
+ * Structure representing the policy applied to background jobs.
+ *
+ * Fields:
+ *   - nice: The minimum niceness of the commands, or `NO_POLICY`.
+ *   - scheduler: The scheduling policy of the commands, or `NO_POLICY`.
+ *   - ioClass: The I/O scheduling class of the commands, or `NO_POLICY`.
+ *   - ioLevel: The level within the I/O scheduling class.
+ */
+typedef struct
+{
+    int nice;
+    int scheduler;
+    int ioClass;
+    int ioLevel;
+} tpolicy;
+
+/**
+ * Structure representing the request sent to a zygote, which is followed by
+ * the arguments and the environment of the command as consecutive `NULL`
+ * terminated strings.
+ *
+ * Fields:
+ *   - pgid: The process group the command joins, or 0 for a new one.
+ *   - terminal: Flag indicating whether the command takes the terminal.
+ *   - mask: The file creation mask of the command.
+ *   - policy: The policy applied to the command, which is only set for
+ *     background jobs.
+ *   - arguments: The number of arguments of the command.
+ *   - size: The number of bytes of the strings following the request.
+ */
+typedef struct
+{
+    pid_t pgid;
+    int terminal;
+    mode_t mask;
+    tpolicy policy;
+    int arguments;
+    int size;
+} tzygoterequest;
+
+/**
+ * Structure representing a builtin loaded from a shared object.
+ *
+ * Fields:
+ *   - name: The name the builtin is called by.
+ *   - handler: The function executing the builtin.
+ *   - library: The handle of the shared object, as returned by `dlopen()`.
+ */
+typedef struct
+{
+    char *name;
+    msh_builtin handler;
+    void *library;
+} tbuiltin;
+
+/**
+ * Structure representing the list of builtins loaded from shared objects.
+ *
+ * Fields:
+ *   - list: The loaded builtins.
+ *   - size: The number of loaded builtins.
+ */
+typedef struct
+{
+    tbuiltin list[MAXIMUM_BUILTINS];
+    int size;
+} tbuiltins;
+
+/**
+ * Structure representing a resource that can be limited.
+ *
+ * Fields:
+ *   - option: The option of `ulimit` naming the resource.
+ *   - resource: The resource, as given to `setrlimit()`.
+ *   - scale: The number of units of `setrlimit()` in the unit displayed.
+ *   - size: Flag indicating whether the resource is a size in bytes, so its
+ *     values accept the `K`, `M`, `G` and `T` suffixes.
+ *   - description: The description displayed by `ulimit -a`.
+ *   - unit: The unit displayed by `ulimit -a`, followed by a comma.
+ */
+typedef struct
+{
+    char option;
+    int resource;
+    int scale;
+    int size;
+    const char *description;
+    const char *unit;
+} tresource;
+
+/**
+ * Structure representing a limit given to `ulimit` or `limit`.
+ *
+ * Fields:
+ *   - resource: A pointer to the resource limited.
+ *   - value: The new value of the limit.
+ *   - set: Flag indicating whether the limit has a value, otherwise it is
+ *     only displayed.
+ *   - soft: Flag indicating whether the soft limit is set or displayed.
+ *   - hard: Flag indicating whether the hard limit is set or displayed.
+ */
+typedef struct
+{
+    const tresource *resource;
+    rlim_t value;
+    int set;
+    int soft;
+    int hard;
+} tlimit;
+
+/**
+ * Structure representing the limits given to `ulimit` or `limit`.
+ *
+ * Fields:
+ *   - list: The limits.
+ *   - size: The number of limits.
+ */
+typedef struct
+{
+    tlimit list[MAXIMUM_LIMITS];
+    int size;
+} tlimits;
+
+/**
+ * Structure representing the placement given to `pin`.
+ *
+ * Fields:
+ *   - mode: The kind of placement, one of the `PIN_` constants.
+ *   - stages: The processors of each command, for `PIN_CPUS`.
+ *   - size: The number of lists of processors given.
+ */
+typedef struct
+{
+    int mode;
+    cpu_set_t stages[MAXIMUM_PID_LIST_SIZE];
+    int size;
+} tplacement;
+
+/**
+ * Structure representing how `batch` splits the arguments of a command.
+ *
+ * Fields:
+ *   - jobs: The number of batches run at once, or 0 if the command is not
+ *     split.
+ *   - fixed: The number of arguments following the command that are given
+ *     to every batch.
+ */
+typedef struct
+{
+    int jobs;
+    int fixed;
+} tbatch;
+
+/**
+ * Structure representing the commands of a pipeline run in several
+ * instances with the `|||` operator.
+ *
+ * Fields:
+ *   - instances: The number of instances of every command, 1 for the
+ *     commands run once.
+ *   - modes: How the records are distributed among the instances of every
+ *     command, such as `SPLIT_HASH`.
+ *   - size: The number of commands run in several instances.
+ */
+typedef struct
+{
+    int instances[MAXIMUM_PID_LIST_SIZE];
+    int modes[MAXIMUM_PID_LIST_SIZE];
+    int size;
+} tstages;
+
+/**
+ * Structure representing the branches of a fan-out, which all read the
+ * output of the commands before them.
+ *
+ * Fields:
+ *   - text: The heap allocated copy of the branches, each one ended by a
+ *     null character, or NULL if the line has no fan-out.
+ *   - branches: The pipeline of every branch.
+ *   - size: The number of branches.
+ *   - stage: The index of the command standing for the branches.
+ */
+typedef struct
+{
+    char *text;
+    char *branches[MAXIMUM_BRANCHES];
+    int size;
+    int stage;
+} tgraph;
+
+/**
+ * Structure representing the settings of the prefixes of a command line,
+ * applied by its children before executing their commands.
+ *
+ * Fields:
+ *   - limits: The resource limits given to `limit`.
+ *   - placement: The placement given to `pin`.
+ *   - batch: The splitting given to `batch`, which only applies to the first
+ *     command.
+ *   - stages: The commands run in several instances, which are given by the
+ *     `|||` operator rather than by a prefix.
+ *   - graph: The branches of a fan-out, given by the `|{` operator.
+ */
+typedef struct
+{
+    tlimits limits;
+    tplacement placement;
+    tbatch batch;
+    tstages stages;
+    tgraph graph;
+} tprefix;
+
+/**
+ * Structure representing groups of processors, such as NUMA nodes.
+ *
+ * Fields:
+ *   - domains: The processors of every group.
+ *   - size: The number of groups.
+ */
+typedef struct
+{
+    cpu_set_t domains[MAXIMUM_DOMAINS];
+    int size;
+} tdomains;
+
+/**
+ * Structure representing the processor topology of the machine.
+ *
+ * Fields:
+ *   - nodes: The NUMA nodes.
+ *   - caches: The groups of processors sharing a level 3 cache.
+ *   - loaded: Flag indicating whether the topology has been read.
+ */
+typedef struct
+{
+    tdomains nodes;
+    tdomains caches;
+    int loaded;
+} ttopology;
+
+/**
+ * Structure representing a command given to `submit`.
+ *
+ * Fields:
+ *   - number: The number of the submission, shown by `queue`.
+ *   - priority: The priority of the command, higher ones starting first.
+ *   - state: Whether the command is pending, running or done.
+ *   - status: The exit status of the command once done.
+ *   - command: The heap allocated command line.
+ *   - submitted: The moment the command was submitted.
+ *   - started: The moment the command started.
+ *   - ended: The moment the command finished.
+ */
+typedef struct
+{
+    int number;
+    int priority;
+    int state;
+    int status;
+    char *command;
+    struct timespec submitted;
+    struct timespec started;
+    struct timespec ended;
+} tsubmission;
+
+/**
+ * Structure representing the commands given to `submit`, which run as
+ * background jobs once a slot is free.
+ *
+ * Fields:
+ *   - list: The heap allocated submissions, in the order they were given,
+ *     whose addresses are handed to the callbacks of their jobs.
+ *   - size: The number of submissions.
+ *   - capacity: The number of submissions that fit in the list.
+ *   - running: The number of submissions running.
+ *   - next: The number of the next submission.
+ */
+typedef struct
+{
+    tsubmission **list;
+    int size;
+    int capacity;
+    int running;
+    int next;
+} tqueue;
+
+/**
+ * Structure representing the state of the shell.
+ *
+ * Fields:
+ *   - jobs: The list of active jobs.
+ *   - variables: The shell variables.
+ *   - mask: The file creation mask of the commands, applied by each child
+ *     so the process embedding the shell keeps its own.
+ *   - formattedMask: The file creation mask, formatted for display.
+ *   - foreground: The processes of the last command line executed in
+ *     foreground.
+ *   - interactive: Flag indicating whether the standard input is a terminal,
+ *     so job control is enabled.
+ *   - pgid: The process group of the shell.
+ *   - zygotes: The pool of zygotes.
+ *   - files: The standard input, output and error of the commands.
+ *   - foregroundGroup: The process group of the job running in the
+ *     foreground, or 0 if there is none. It can be read by signal handlers.
+ *   - result: The outcome of the last pipeline executed.
+ *   - builtins: The builtins loaded from shared objects.
+ *   - topology: The processor topology, read by `pin` when needed.
+ *   - pipefail: Flag indicating whether the `pipefail` option is set.
+ *   - queue: The commands given to `submit`.
+ *   - exited: Flag indicating whether `exit` was executed.
+ */
+typedef struct msh_context
+{
+    tjobs jobs;
+    tvariables variables;
+    mode_t mask;
+    int formattedMask;
+    tjob foreground;
+    int interactive;
+    pid_t pgid;
+    tzygotes zygotes;
+    int files[STANDARD_FILES];
+    volatile sig_atomic_t foregroundGroup;
+    msh_result result;
+    tbuiltins builtins;
+    ttopology topology;
+    int pipefail;
+    tqueue queue;
+    int exited;
+} tshell;
+
+/**
+ * Structure representing a growable buffer whose contents are appended at
+ * its end.
+ *
+ * Fields:
+ *   - data: The contents of the buffer.
+ *   - size: The number of bytes in use.
+ *   - capacity: The number of bytes allocated.
+ */
+typedef struct
+{
+    char *data;
+    int size;
+    int capacity;
+} tarena;
+
+/**
+ * Structure representing an instance of a command run with `|||`.
+ *
+ * Fields:
+ *   - pid: The process identifier of the instance.
+ *   - input: The pipe the instance reads its records from, or `NO_FILE`
+ *     once closed.
+ *   - output: The pipe the output of the instance is read from, or
+ *     `NO_FILE` once it ended.
+ *   - pending: The records not written to the instance yet.
+ *   - written: The number of bytes of `pending` already written.
+ *   - received: The output of the instance not written yet, which is the
+ *     last incomplete line, or the whole output while an instance keeping
+ *     the order waits for the previous ones.
+ *   - sequence: The number of the chunk given to an instance keeping the
+ *     order, or -1 if the slot is free.
+ *   - lost: The number of records that never reached the instances run in
+ *     the slot, since they exited first.
+ */
+typedef struct
+{
+    pid_t pid;
+    int input;
+    int output;
+    tarena pending;
+    int written;
+    tarena received;
+    int sequence;
+    int lost;
+} tinstance;
+
+/**
+ * Structure representing a command run by `parallel` for one item.
+ *
+ * Fields:
+ *   - pid: The process identifier of the command, or 0 if the slot is free.
+ *   - item: The index of the item.
+ *   - status: The exit status of the command, or -1 until it is reaped.
+ *   - captured: The standard output and error of the command, indexed by
+ *     their file descriptor, written at once when it finishes.
+ *   - start: The moment the command started.
+ */
+typedef struct
+{
+    pid_t pid;
+    int item;
+    int status;
+    tarena captured[STANDARD_FILES];
+    struct timespec start;
+} ttask;
+
+/**
+ * Structure representing a node of the tree a command line is parsed into.
+ *
+ * Fields:
+ *   - type: The type of the node, such as `NODE_PIPELINE` or `NODE_AND`.
+ *   - text: The text of the pipeline, ending with a newline, if the node is
+ *     a `NODE_PIPELINE`.
+ *   - left: The first operand of the node, otherwise.
+ *   - right: The second operand of the node, otherwise.
+ */
+typedef struct tnode
+{
+    int type;
+    char *text;
+    struct tnode *left;
+    struct tnode *right;
+} tnode;
+
+/**
+ * Structure representing the paths matched by a glob pattern.
+ *
+ * Fields:
+ *   - list: Array of heap allocated paths.
+ *   - size: The number of paths in the list.
+ *   - capacity: The number of paths the list can hold before growing.
+ */
+typedef struct
+{
+    char **list;
+    int size;
+    int capacity;
+} tmatches;
+
+/**
+ * Structure representing a thread walking part of a recursive `**` pattern.
+ *
+ * Fields:
+ *   - dirfd: Directory the shared subdirectory names are relative to.
+ *   - path: Path prefix of that directory, ending with `/` if not empty.
+ *   - length: Length of the path prefix.
+ *   - components: Pattern components, split by `/`.
+ *   - count: The number of pattern components.
+ *   - index: Index of the `**` component being expanded.
+ *   - directoriesOnly: Flag indicating whether the pattern ends with `/`.
+ *   - directories: Subdirectory names shared by all the workers.
+ *   - size: The number of shared subdirectory names.
+ *   - next: Index of the next subdirectory to be walked, shared by all the
+ *     workers.
+ *   - matches: Paths matched by this worker.
+ */
+typedef struct
+{
+    int dirfd;
+    const char *path;
+    int length;
+    char **components;
+    int count;
+    int index;
+    int directoriesOnly;
+    char **directories;
+    int size;
+    int *next;
+    tmatches matches;
+} tglobworker;
+
+static int executeList(const char buffer[], tshell *shell);
+static int executeLine(const char buffer[], tshell *shell);
+static int redirect(const tline *line, const int first, const int last);
+static int auxiliarRedirect(char *filename, const int FLAGS, const int STD_FILENO);
+static void run(const tline *line, const int number, char **environment, tbuiltins *builtins);
+static void execute(char **arguments, char **environment);
+static void leave(const int status);
+static long argumentsSize(char **arguments, const int count);
+static long argumentSpace(char **environment);
+static int parseBatch(char **arguments, tbatch *batch);
+static int runBatches(char **arguments, char **environment, const tbatch *batch);
+static void waitBatch(pid_t *pids, int *numbers, int *running, int *failed, int *status);
+static int splitStages(char *buffer, tstages *stages);
+static int runInstances(const tline *line, const int number, char **environment, tbuiltins *builtins, const int size, const int mode);
+static int startInstance(tinstance *instance, tinstance *instances, const int size, const tline *line, const int number, char **environment, tbuiltins *builtins);
+static void dispatchRecords(tinstance *instances, const int size, const int mode, tarena *carry, const int ending, int *next);
+static int wantsRecords(const tinstance *instances, const int size, const int mode, const tarena *carry);
+static void writeRecords(tinstance *instance, const int mode);
+static void readOutput(tinstance *instance, const int mode, const int emitted);
+static void waitInstance(tinstance *instance, const int rank, int *failed, int *status);
+static int recordsLength(const char *data, const int size);
+static int recordsCount(const char *data, const int size);
+static void consume(tarena *arena, const int size);
+static unsigned int recordHash(const char *record, const int length);
+static void emit(const char *data, int size);
+static int splitGraph(char *buffer, tgraph *graph);
+static int runGraph(const tgraph *graph, tshell *shell, char **environment);
+static int startBranch(const tline *line, char **environment, tbuiltins *builtins, int *input, int *output, pid_t *last);
+static void fanOut(int *inputs, const int size);
+static int deliver(int file, const char *data, int size);
+static void mergeOutputs(tinstance *outputs, const int size);
+static int mshparallel(char **arguments, char **environment);
+static int parseParallel(char **arguments, int *jobs, int *verbose);
+static char **readItems(tarena *arena, int *count);
+static void startTask(ttask *task, struct pollfd *descriptors, char **command, const char *item, char **environment);
+static char *placeItem(const char *word, const char *item);
+static void finishTask(ttask *task, struct pollfd *descriptors, char **items, const int verbose, int *failed, int *status);
+static int executeExternalCommands(const tline *line, tshell *shell, const char buffer[], const tprefix *prefix);
+static void initializeZygotes(tzygotes *zygotes, const int capacity);
+static void fillZygotes(tzygotes *zygotes);
+static void closeZygotes(tzygotes *zygotes);
+static void emptyZygotes(tzygotes *zygotes);
+static pid_t launch(tzygotes *zygotes, char **arguments, char **environment, const int files[], const mode_t mask, const tpolicy *policy, const pid_t pgid, const int terminal);
+static void zygote(int socket);
+static int transfer(int socket, char *data, int size, const int sending);
+static int mshbenchmark(char **arguments, tshell *shell);
+static int session(int client, tshell *shell);
+static int offer(int socket, const char *text, int file);
+static int mshenable(char **arguments, tbuiltins *builtins);
+static tbuiltin *findBuiltin(tbuiltins *builtins, const char *name);
+static void removeBuiltin(tbuiltin *builtin, tbuiltins *builtins);
+static int runBuiltin(const tline *line, msh_builtin handler, tshell *shell);
+static int countArguments(char **arguments);
+static int mshulimit(char **arguments, tzygotes *zygotes);
+static int parseLimits(char **arguments, tlimits *limits, const int prefix);
+static int parseLimit(const char *text, const tresource *resource, rlim_t *value);
+static const tresource *findResource(const char option);
+static int applyLimits(const tlimits *limits, const char *name);
+static int prefixed(char **arguments);
+static int stripPrefixes(tcommand *command, tprefix *prefix);
+static int mshcd(const char *directory, tvariables *variables);
+static int mshumask(const char *mask, mode_t *fileMask, int *formattedMask);
+static void printMask(const int mask);
+static int octal(const char *number);
+static int mshexit(tjobs *jobs, tvariables *variables);
+static int waitExit(struct pollfd *descriptors, tprocess **processes, const int size, const struct timespec *start, const int timeout);
+static long milliseconds(const struct timespec *start);
+static int running(tjobs *jobs, const int *signals);
+static int mshjobs(const char *option, tjobs *jobs);
+static void printUsage(const tjob *job);
+static int finished(tjob *job, const int subreaper);
+static int mshfg(const char *job, tshell *shell);
+static int mshbg(const char *job, tjobs *jobs);
+static int mshkill(char **arguments, tjobs *jobs);
+static int jobNumber(const char *job, tjobs *jobs);
+static int signalNumber(const char *name);
+static int waitJob(tjob *job, tshell *shell, const int resume);
+static void terminateUpstream(const tjob *job, const int index);
+static int jobStatus(const tjob *job);
+static void stop(const tjob *job, tjobs *jobs);
+static void delete(const int job, tjobs *jobs);
+static void initializeJobs(tjobs *jobs, tvariables *variables);
+static void initializeCgroups(tjobs *jobs, tvariables *variables);
+static void createCgroup(tjob *job, tjobs *jobs);
+static void releaseCgroup(tjob *job, tjobs *jobs);
+static pid_t spawn(const int cgroup);
+static pid_t retrySpawn(tjob *job, tjobs *jobs);
+static void admit(tjob *job, tjobs *jobs, const int maximum, const int commands);
+static int reclaim(tjob *job, tjobs *jobs, const int options);
+static int runningProcesses(const tjob *job);
+static int writeCgroup(const int cgroup, const char *name, const char *value);
+static int readCgroup(const int cgroup, const char *name, const char *key, unsigned long long *value);
+static void printCgroup(const tjob *job);
+static int mshjob(char **arguments, tjobs *jobs);
+static int mshpin(char **arguments, tshell *shell);
+static int parsePlacement(char **arguments, const int index, tplacement *placement);
+static int parseCpus(const char *text, cpu_set_t *cpus);
+static void printCpus(const cpu_set_t *cpus);
+static void loadTopology(ttopology *topology);
+static void addDomain(tdomains *domains, const cpu_set_t *cpus);
+static int readCpus(const char *path, cpu_set_t *cpus);
+static int readSystemFile(const char *path, char *buffer, const int size);
+static void placeJob(const tplacement *placement, tjob *job, tshell *shell, cpu_set_t *cpus, const int commands);
+static int pinProcess(const pid_t pid, const cpu_set_t *cpus);
+static void readPolicy(tvariables *variables, tpolicy *policy);
+static void applyPolicy(const tpolicy *policy, const pid_t pid);
+static int mshrenice(char **arguments, tjobs *jobs);
+static int mshsubmit(const char *buffer, char **arguments, tshell *shell);
+static int mshqueue(char **arguments, tqueue *queue);
+static void schedule(tshell *shell);
+static int querySlots(tshell *shell);
+static void finishSubmission(msh_context *shell, int job, const msh_result *result, void *data);
+static long interval(const struct timespec *start, const struct timespec *end);
+static void resetSignals();
+static tline *expand(const tline *line, tvariables *variables);
+static void release(tline *line);
+static int wildcard(const char *word);
+static int match(const char *pattern, const char *name);
+static void expandGlob(const char *pattern, tmatches *matches, const int threads);
+static void walk(int dirfd, char *path, int length, char **components, int count, int index, int directoriesOnly, int threads, tmatches *matches);
+static void descend(int dirfd, const char *name, char *path, int length, char **components, int count, int index, int directoriesOnly, int threads, tmatches *matches);
+static void *globWorker(void *argument);
+static void walkParallel(int dirfd, char *path, int length, char **components, int count, int index, int directoriesOnly, char **directories, int size, int threads, tmatches *matches);
+static int directory(int dirfd, const char *name, unsigned char type, int follow);
+static void addMatch(tmatches *matches, const char *path, int length, const char *name);
+static void radixSort(char **list, char **auxiliar, unsigned char *keys, int size, int depth);
+static void initializeVariables(tvariables *variables, char **environment);
+static unsigned int hash(const char *name, int length);
+static tvariable *lookup(tvariables *variables, const char *name, int length, unsigned int nameHash);
+static const char *getVariable(tvariables *variables, const char *name, int length);
+static void setVariable(tvariables *variables, const char *name, int length, const char *value, int exported);
+static void unsetVariable(tvariables *variables, const char *name, int length);
+static void grow(tvariables *variables);
+static char **exportedEnvironment(tvariables *variables);
+static void releaseVariables(tvariables *variables);
+static int identifier(const char *name, int length);
+static int nameLength(const char *text);
+static int assignment(const char *word);
+static char *expandVariables(const char *word, tvariables *variables);
+static int mshassign(char **arguments, tvariables *variables);
+static int mshset(char **arguments, int *pipefail);
+static int mshexport(char **arguments, tvariables *variables);
+static int mshunset(char **arguments, tvariables *variables);
+static void reserve(tarena *arena, int size);
+static void append(tarena *arena, const char *data, int size);
+static char *substitute(const char *buffer, tshell *shell, int *status);
+static int closing(const char *start, const char open, const char close);
+static int capture(const char *command, tshell *shell, tarena *arena);
+static int captureInProcess(const char *command, tshell *shell, tarena *arena);
+static tnode *parse(const char *buffer, int *error);
+static tnode *parseList(const char **cursor, int *error);
+static tnode *parseAndOr(const char **cursor, int *error);
+static tnode *parsePipeline(const char **cursor, int *error);
+static tnode *combine(const int type, tnode *left, tnode *right);
+static int separator(const char *cursor, const char *start);
+static int evaluate(const tnode *node, tshell *shell);
+static void destroy(tnode *node);
+static int exitStatus(const int status);
+static void addProcess(tjob *job, const int index, const pid_t pid);
+static int waitProcess(tprocess *process);
+static void reap(tjobs *jobs);
+static int charge(tjobs *jobs, const pid_t pid, const pid_t group, const int status, const struct rusage *usage);
+static void addUsage(struct rusage *total, const struct rusage *usage);
+static void setStatus(tshell *shell, const tjob *job, const int status);
+static void collect(const tjob *job, msh_result *result);
+static int parameterLength(const char *text);
+static const char *element(const char *value, int index, int *length);
+
+/**
+ * Create a shell whose variables are initialized from an environment.
+ *
+ * @param environment The `NULL` terminated array of `NAME=value` strings.
+ * @return The new shell, to be freed with `msh_destroy()`.
+ */
+msh_context *msh_create(char **environment)
+{
+    const char *value;
+    tshell *shell;
+    int index;
+
+    shell = calloc(1, sizeof(tshell));
+
+    shell->mask = DEFAULT_UNIX_MASK;
+    shell->formattedMask = DEFAULT_UNIX_FORMATTED_MASK;
+
+    initializeVariables(&shell->variables, environment);
+    initializeJobs(&shell->jobs, &shell->variables);
+    setStatus(shell, NULL, EXIT_SUCCESS);
+
+    shell->interactive = 0;
+    shell->pgid = getpgrp();
+
+    for (index = 0; index < STANDARD_FILES; index++)
+    {
+        shell->files[index] = index;
+    }
+
+    value = getVariable(&shell->variables, ZYGOTES, strlen(ZYGOTES));
+    initializeZygotes(&shell->zygotes, value != NULL ? atoi(value) : 0);
+
+    return shell;
+}
+
+/**
+ * Free a shell, stopping its zygotes. Its jobs keep running.
+ *
+ * @param shell A pointer to the structure representing the shell state.
+ */
+void msh_destroy(msh_context *shell)
+{
+    int submission;
+
+    closeZygotes(&shell->zygotes);
+
+    while (shell->builtins.size > 0)
+    {
+        removeBuiltin(&shell->builtins.list[0], &shell->builtins);
+    }
+
+    releaseVariables(&shell->variables);
+
+    if (shell->jobs.cgroups >= 0)
+    {
+        close(shell->jobs.cgroups);
+    }
+
+    for (submission = 0; submission < shell->queue.size; submission++)
+    {
+        free(shell->queue.list[submission]->command);
+        free(shell->queue.list[submission]);
+    }
+
+    free(shell->queue.list);
+    free(shell->jobs.list);
+    free(shell);
+}
+
+/**
+ * Set the standard input, output and error of the commands executed
+ * afterwards.
+ *
+ * @param shell A pointer to the structure representing the shell state.
+ * @param input The standard input of the commands.
+ * @param output The standard output of the commands.
+ * @param error The standard error of the commands.
+ */
+void msh_set_files(msh_context *shell, int input, int output, int error)
+{
+    shell->files[STDIN_FILENO] = input;
+    shell->files[STDOUT_FILENO] = output;
+    shell->files[STDERR_FILENO] = error;
+}
+
+/**
+ * Execute a command line and wait for it.
+ *
+ * The line is copied so it can end in a newline, as the lines read by
+ * `fgets()` do, and so it can be constant.
+ *
+ * @param shell A pointer to the structure representing the shell state.
+ * @param line The command line.
+ * @param result Where the outcome of the last pipeline is stored, or NULL.
+ * @return The exit status of the command line, or -1 if it is too long.
+ */
+int msh_run(msh_context *shell, const char *line, msh_result *result)
+{
+    char buffer[MAXIMUM_LINE_LENGTH];
+    int length;
+    int status;
+
+    length = strlen(line);
+
+    if (length > 0 && line[length - 1] == '\n')
+    {
+        length--;
+    }
+
+    if (length + 2 > MAXIMUM_LINE_LENGTH)
+    {
+        return -1;
+    }
+
+    memcpy(buffer, line, length);
+    buffer[length] = '\n';
+    buffer[length + 1] = '\0';
+
+    status = executeList(buffer, shell);
+
+    if (result != NULL)
+    {
+        *result = shell->result;
+    }
+
+    return status;
+}
+
+/**
+ * Start a pipeline in background without waiting for it, and remember the
+ * function to be called once it finishes.
+ *
+ * @param shell A pointer to the structure representing the shell state.
+ * @param line The pipeline, without a trailing `&`.
+ * @param callback The function called when the pipeline finishes, or NULL.
+ * @param data A pointer handed to the callback.
+ * @return The number of the job, 0 if the line ran at once, or -1 if it is
+ * too long or the list of jobs is full.
+ */
+int msh_start(msh_context *shell, const char *line, msh_callback callback, void *data)
+{
+    char buffer[MAXIMUM_LINE_LENGTH];
+    int length;
+    int size;
+
+    length = strlen(line);
+
+    if (length > 0 && line[length - 1] == '\n')
+    {
+        length--;
+    }
+
+    if (length + 3 > MAXIMUM_LINE_LENGTH)
+    {
+        return -1;
+    }
+
+    // The list of jobs wraps around once full, overwriting the first job
+    if (shell->jobs.size >= MAXIMUM_JOB_LIST_SIZE - 1)
+    {
+        return -1;
+    }
+
+    memcpy(buffer, line, length);
+    strcpy(buffer + length, "&\n");
+
+    size = shell->jobs.size;
+
+    executeList(buffer, shell);
+
+    // Internal commands always run in the shell itself
+    if (shell->jobs.size == size)
+    {
+        if (callback != NULL)
+        {
+            callback(shell, 0, &shell->result, data);
+        }
+
+        return 0;
+    }
+
+    shell->jobs.list[shell->jobs.size - 1].callback = callback;
+    shell->jobs.list[shell->jobs.size - 1].data = data;
+
+    return shell->jobs.size;
+}
+
+/**
+ * Reap the jobs that finished, without blocking, and call the callbacks of
+ * the ones started with `msh_start()`, which are then removed from the list
+ * of jobs. The zygotes used since the last call are replaced.
+ *
+ * @param shell A pointer to the structure representing the shell state.
+ * @return The number of callbacks called.
+ */
+int msh_poll(msh_context *shell)
+{
+    msh_result result;
+    msh_callback callback;
+    void *data;
+    tjob *job;
+    int j;
+    int count;
+
+    reap(&shell->jobs);
+
+    count = 0;
+
+    // Backwards, so deleting a job does not move the ones left to check
+    for (j = shell->jobs.size - 1; j >= 0; j--)
+    {
+        job = &shell->jobs.list[j];
+
+        if (job->callback == NULL || !finished(job, shell->jobs.subreaper))
+        {
+            continue;
+        }
+
+        collect(job, &result);
+        callback = job->callback;
+        data = job->data;
+
+        delete (j, &shell->jobs);
+
+        callback(shell, j + 1, &result, data);
+        count++;
+    }
+
+    // Finished submissions leave their slots to the pending ones
+    schedule(shell);
+
+    // Zygotes used by the last command lines are replaced while the shell
+    // is idle, rather than while it starts commands
+    fillZygotes(&shell->zygotes);
+
+    return count;
+}
+
+/**
+ * Wait until a file can be read, reaping the background jobs as they finish
+ * and starting the commands given to `submit` as slots become free.
+ *
+ * Without a file, the input of the shell ended and nobody will list the
+ * finished jobs anymore, so the ones without a callback are removed when
+ * pending commands need their room in a full list of jobs. The other jobs
+ * are then waited for too, since they hold the rest of the list.
+ *
+ * @param shell A pointer to the structure representing the shell state.
+ * @param file The file descriptor, or -1 to wait until every submitted
+ * command finished.
+ * @return 1 if the file can be read, 0 otherwise.
+ */
+int msh_wait(msh_context *shell, int file)
+{
+    struct pollfd *descriptors;
+    tjob *job;
+    int size, j, index;
+    int readable, pending, full;
+
+    for (;;)
+    {
+        msh_poll(shell);
+
+        pending = 0;
+
+        for (index = 0; index < shell->queue.size; index++)
+        {
+            pending += shell->queue.list[index]->state == SUBMISSION_PENDING;
+        }
+
+        full = file < 0 && pending > 0 && !shell->exited && shell->jobs.size >= MAXIMUM_JOB_LIST_SIZE - 1;
+
+        if (full)
+        {
+            // Backwards, so deleting a job does not move the ones left to check
+            for (j = shell->jobs.size - 1; j >= 0; j--)
+            {
+                if (shell->jobs.list[j].callback == NULL && finished(&shell->jobs.list[j], shell->jobs.subreaper))
+                {
+                    delete (j, &shell->jobs);
+                }
+            }
+
+            schedule(shell);
+            full = shell->jobs.size >= MAXIMUM_JOB_LIST_SIZE - 1;
+        }
+
+        size = file >= 0;
+
+        for (j = 0; j < shell->jobs.size; j++)
+        {
+            size += shell->jobs.list[j].size;
+        }
+
+        descriptors = malloc(sizeof(struct pollfd) * size);
+        size = 0;
+
+        if (file >= 0)
+        {
+            descriptors[size].fd = file;
+            descriptors[size++].events = POLLIN;
+        }
+
+        // Only the jobs with a callback have something to do once finished,
+        // unless pending commands wait for room in the list. Stopped jobs
+        // would never finish
+        for (j = 0; j < shell->jobs.size; j++)
+        {
+            job = &shell->jobs.list[j];
+
+            for (index = 0; index < job->size && (job->callback != NULL || full) && !job->stopped; index++)
+            {
+                if (!job->processes[index].reaped && (descriptors[size].fd = syscall(SYS_pidfd_open, job->processes[index].pid, 0)) >= 0)
+                {
+                    descriptors[size++].events = POLLIN;
+                }
+            }
+        }
+
+        if (size == 0 || (file < 0 && shell->queue.running == 0 && (pending == 0 || shell->exited)))
+        {
+            free(descriptors);
+            return 0;
+        }
+
+        readable = poll(descriptors, size, -1) < 0 && errno != EINTR;
+        readable = readable || (file >= 0 && descriptors[0].revents != 0);
+
+        for (index = file >= 0; index < size; index++)
+        {
+            close(descriptors[index].fd);
+        }
+
+        free(descriptors);
+
+        if (readable)
+        {
+            return file >= 0;
+        }
+    }
+}
+
+/**
+ * Get the process group of the job running in the foreground.
+ *
+ * @param shell A pointer to the structure representing the shell state.
+ * @return The process group, or 0 if nothing is running in the foreground.
+ */
+pid_t msh_foreground(const msh_context *shell)
+{
+    return shell->foregroundGroup;
+}
+
+/**
+ * Check whether `exit` was executed, so the program embedding the shell can
+ * end instead of the shell ending it.
+ *
+ * @param shell A pointer to the structure representing the shell state.
+ * @return 1 if `exit` was executed, 0 otherwise.
+ */
+int msh_exited(const msh_context *shell)
+{
+    return shell->exited;
+}
+
+
+/**
+ * Execute a command line made of pipelines separated by `;`, `&`, `&&` and
+ * `||`.
+ *
+ * The line is parsed once into a tree that is then evaluated, running the
+ * right side of `&&` only if its left side succeeded and the right side of
+ * `||` only if its left side failed.
+ *
+ * @param buffer A buffer where the command line instruction is stored.
+ * @param shell A pointer to the structure representing the shell state.
+ * @return The exit status of the last pipeline executed.
+ */
+static int executeList(const char buffer[], tshell *shell)
+{
+    tnode *root;
+    int error;
+    int status;
+
+    root = parse(buffer, &error);
+
+    if (error)
+    {
+        fprintf(stderr, "Error. Syntax error\n");
+        destroy(root);
+        return EXIT_FAILURE;
+    }
+
+    status = root != NULL ? evaluate(root, shell) : EXIT_SUCCESS;
+
+    destroy(root);
+
+    return status;
+}
+
+/**
+ * Execute a pipeline, running it as an internal command if it is one or as a
+ * series of external commands otherwise.
+ *
+ * Command substitutions are replaced by the output of their commands before
+ * the line is tokenized, and the words of the tokenized line are expanded
+ * before being executed.
+ *
+ * @param buffer A buffer where the pipeline instruction is stored.
+ * @param shell A pointer to the structure representing the shell state.
+ * @return The exit status of the pipeline.
+ */
+static int executeLine(const char buffer[], tshell *shell)
+{
+    tline *line;
+    tline *expandedLine;
+    char *substitutedBuffer;
+    char *submittedBuffer;
+    char **firstCommandArguments;
+    tbuiltin *builtin;
+    tprefix prefix;
+    tjob *job;
+    int status;
+    int captured;
+
+    captured = EXIT_SUCCESS;
+    substitutedBuffer = substitute(buffer, shell, &captured);
+    submittedBuffer = NULL;
+
+    // A submitted line is queued with its substitutions done, so they do not
+    // run again when it starts. The branches and stages are taken out of the
+    // buffer below, so it is copied before
+    if (strncmp(substitutedBuffer + strspn(substitutedBuffer, " \t"), "submit", 6) == 0)
+    {
+        submittedBuffer = strdup(substitutedBuffer);
+    }
+
+    // The branches are taken out first, so the commands are counted on the
+    // pipeline left
+    if (splitGraph(substitutedBuffer, &prefix.graph) != EXIT_SUCCESS || splitStages(substitutedBuffer, &prefix.stages) != EXIT_SUCCESS)
+    {
+        free(prefix.graph.text);
+        free(substitutedBuffer);
+        free(submittedBuffer);
+        setStatus(shell, NULL, EXIT_FAILURE);
+        return EXIT_FAILURE;
+    }
+
+    line = tokenize(substitutedBuffer);
+
+    if (line == NULL || line->ncommands < 1)
+    {
+        free(prefix.graph.text);
+        free(substitutedBuffer);
+        free(submittedBuffer);
+        status = line == NULL ? EXIT_FAILURE : captured;
+        setStatus(shell, NULL, status);
+        return status;
+    }
+
+    expandedLine = expand(line, &shell->variables);
+    line = expandedLine;
+
+    free(substitutedBuffer);
+
+    firstCommandArguments = line->commands[0].argv;
+
+    // Every word of the first command expanded to nothing, so only its
+    // substitutions ran
+    if (firstCommandArguments[COMMAND] == NULL)
+    {
+        free(prefix.graph.text);
+        free(submittedBuffer);
+        release(expandedLine);
+        setStatus(shell, NULL, captured);
+        return captured;
+    }
+
+    // Internal commands and background jobs only report a single status
+    job = NULL;
+
+    if (prefixed(firstCommandArguments) || prefix.stages.size > 0 || prefix.graph.size > 0)
+    {
+        status = stripPrefixes(&line->commands[0], &prefix);
+
+        // Prefixes only apply to the children, so internal commands are
+        // never run by the shell itself
+        if (status == EXIT_SUCCESS)
+        {
+            status = executeExternalCommands(line, shell, buffer, &prefix);
+
+            if (!line->background && !shell->foreground.stopped)
+            {
+                job = &shell->foreground;
+            }
+        }
+    }
+    else if (strcmp(firstCommandArguments[COMMAND], "cd") == 0)
+    {
+        status = mshcd(firstCommandArguments[DIRECTORY], &shell->variables);
+    }
+    else if (assignment(firstCommandArguments[COMMAND]))
+    {
+        status = mshassign(firstCommandArguments, &shell->variables);
+
+        // Assignments report the status of their last substitution, as
+        // in `x=$(false)`
+        if (status == EXIT_SUCCESS)
+        {
+            status = captured;
+        }
+    }
+    else if (strcmp(firstCommandArguments[COMMAND], "set") == 0)
+    {
+        status = mshset(firstCommandArguments, &shell->pipefail);
+    }
+    else if (strcmp(firstCommandArguments[COMMAND], "export") == 0)
+    {
+        status = mshexport(firstCommandArguments, &shell->variables);
+    }
+    else if (strcmp(firstCommandArguments[COMMAND], "unset") == 0)
+    {
+        status = mshunset(firstCommandArguments, &shell->variables);
+    }
+    else if (strcmp(firstCommandArguments[COMMAND], "umask") == 0)
+    {
+        status = mshumask(firstCommandArguments[MASK], &shell->mask, &shell->formattedMask);
+    }
+    else if (strcmp(firstCommandArguments[COMMAND], "exit") == 0)
+    {
+        status = mshexit(&shell->jobs, &shell->variables);
+        shell->exited = 1;
+    }
+    else if (strcmp(firstCommandArguments[COMMAND], "jobs") == 0)
+    {
+        status = mshjobs(firstCommandArguments[JOB], &shell->jobs);
+    }
+    else if (strcmp(firstCommandArguments[COMMAND], "fg") == 0)
+    {
+        status = mshfg(firstCommandArguments[JOB], shell);
+    }
+    else if (strcmp(firstCommandArguments[COMMAND], "bg") == 0)
+    {
+        status = mshbg(firstCommandArguments[JOB], &shell->jobs);
+    }
+    else if (strcmp(firstCommandArguments[COMMAND], "kill") == 0)
+    {
+        status = mshkill(firstCommandArguments, &shell->jobs);
+    }
+    else if (strcmp(firstCommandArguments[COMMAND], "job") == 0)
+    {
+        status = mshjob(firstCommandArguments, &shell->jobs);
+    }
+    else if (strcmp(firstCommandArguments[COMMAND], "pin") == 0)
+    {
+        status = mshpin(firstCommandArguments, shell);
+    }
+    else if (strcmp(firstCommandArguments[COMMAND], "renice") == 0)
+    {
+        status = mshrenice(firstCommandArguments, &shell->jobs);
+    }
+    else if (strcmp(firstCommandArguments[COMMAND], "submit") == 0)
+    {
+        status = mshsubmit(submittedBuffer != NULL ? submittedBuffer : buffer, firstCommandArguments, shell);
+    }
+    else if (strcmp(firstCommandArguments[COMMAND], "queue") == 0)
+    {
+        status = mshqueue(firstCommandArguments, &shell->queue);
+    }
+    else if (strcmp(firstCommandArguments[COMMAND], "benchmark") == 0)
+    {
+        status = mshbenchmark(firstCommandArguments, shell);
+    }
+    else if (strcmp(firstCommandArguments[COMMAND], "enable") == 0)
+    {
+        status = mshenable(firstCommandArguments, &shell->builtins);
+    }
+    else if (strcmp(firstCommandArguments[COMMAND], "ulimit") == 0)
+    {
+        status = mshulimit(firstCommandArguments, &shell->zygotes);
+    }
+    else if (line->ncommands == 1 && !line->background && (builtin = findBuiltin(&shell->builtins, firstCommandArguments[COMMAND])) != NULL)
+    {
+        status = runBuiltin(line, builtin->handler, shell);
+    }
+    else
+    {
+        status = executeExternalCommands(line, shell, buffer, NULL);
+
+        // A stopped command line was moved to the list of jobs
+        if (!line->background && !shell->foreground.stopped)
+        {
+            job = &shell->foreground;
+        }
+    }
+
+    setStatus(shell, job, status);
+
+    free(prefix.graph.text);
+    free(submittedBuffer);
+    release(expandedLine);
+
+    return status;
+}
+
+/**
+ * Redirect standard input, output, and error based on the information provided
+ * in the given command line structure.
+ *
+ * Called from child processes, and by the shell itself only around a loaded
+ * builtin, whose standard files are restored afterwards. The input
+ * redirection only applies to the first command of the line and the output
+ * redirection to the last one.
+ *
+ * @param line A pointer to a `tline` structure representing the command line.
+ * @param first Flag indicating whether the command is the first of the line.
+ * @param last Flag indicating whether the command is the last of the line.
+ * @return `EXIT_SUCCESS` if every file was opened, `EXIT_FAILURE` otherwise.
+ */
+static int redirect(const tline *line, const int first, const int last)
+{
+    if (line->redirect_error != NULL && auxiliarRedirect(line->redirect_error, FILE_WRITE, STDERR_FILENO) != EXIT_SUCCESS)
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (first && line->redirect_input != NULL && auxiliarRedirect(line->redirect_input, FILE_READ, STDIN_FILENO) != EXIT_SUCCESS)
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (last && line->redirect_output != NULL && auxiliarRedirect(line->redirect_output, FILE_WRITE, STDOUT_FILENO) != EXIT_SUCCESS)
+    {
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Auxiliary function for redirecting a specific file descriptor based on the
+ * given filename and flags.
+ *
+ * If the file cannot be opened, an error message is printed to `stderr`.
+ *
+ * @param filename The name of the file to be used for redirection.
+ * @param FLAGS The flags to be used in `open()` for opening the file (e.g.,
+ * `FILE_READ`, `FILE_WRITE`).
+ * @param STD_FILENO The standard file descriptor to be redirected (e.g.,
+ * `STDIN_FILENO`, `STDOUT_FILENO`).
+ * @return `EXIT_SUCCESS` if the file was opened, `EXIT_FAILURE` otherwise.
+ */
+static int auxiliarRedirect(char *filename, const int FLAGS, const int STD_FILENO)
+{
+    int fd;
+
+    fd = open(filename, FLAGS, FILE_PERMISSIONS);
+    if (fd < 0)
+    {
+        fprintf(stderr, "%s: Error. %s\n", filename, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    if (fd != STD_FILENO)
+    {
+        dup2(fd, STD_FILENO);
+        close(fd);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Run a command specified by the given command line structure.
+ *
+ * @param line A pointer to a `tline` structure representing the command line.
+ * @param number The index of the command to be ran within the command line.
+ * @param environment The `NULL` terminated array of exported variables.
+ * @param builtins A pointer to the list of builtins loaded from shared
+ * objects, which are executed by the child itself.
+ *
+ * If the command execution fails, an error message is printed to `stderr`
+ * indicating that was not found, and the program exits with the
+ * `COMMAND_NOT_FOUND` status.
+ */
+static void run(const tline *line, const int number, char **environment, tbuiltins *builtins)
+{
+    char **arguments;
+    char *command;
+    tbuiltin *builtin;
+
+    arguments = line->commands[number].argv;
+    command = arguments[COMMAND];
+
+    if (command == NULL)
+    {
+        leave(EXIT_SUCCESS);
+    }
+
+    // A loaded builtin is already in memory, so the child skips the exec
+    builtin = findBuiltin(builtins, command);
+    if (builtin != NULL)
+    {
+        leave(builtin->handler(countArguments(arguments), arguments, environment));
+    }
+
+    execute(arguments, environment);
+}
+
+/**
+ * Replace the process with a program, exiting with `COMMAND_NOT_FOUND` if it
+ * does not exist or `CANNOT_EXECUTE` if it could not be executed.
+ *
+ * @param arguments The `NULL` terminated array of arguments, starting with
+ * the program.
+ * @param environment The `NULL` terminated array of exported variables.
+ */
+static void execute(char **arguments, char **environment)
+{
+    execvpe(arguments[COMMAND], arguments, environment);
+
+    if (errno == ENOENT)
+    {
+        fprintf(stderr, "%s: Command not found\n", arguments[COMMAND]);
+        leave(COMMAND_NOT_FOUND);
+    }
+
+    fprintf(stderr, "%s: Error. %s\n", arguments[COMMAND], strerror(errno));
+    leave(CANNOT_EXECUTE);
+}
+
+/**
+ * End a child forked by the shell, writing the output it left buffered.
+ *
+ * `_exit()` is used instead of `exit()`, so the `atexit()` handlers of the
+ * program embedding the shell never run in its children.
+ *
+ * @param status The exit status of the child.
+ */
+static void leave(const int status)
+{
+    fflush(stdout);
+    fflush(stderr);
+    _exit(status);
+}
+
+/**
+ * Compute the space taken by arguments in the memory `execve()` copies them
+ * to, which is their characters and their pointers.
+ *
+ * @param arguments The array of arguments.
+ * @param count The number of arguments counted.
+ * @return The size in bytes, or -1 if an argument is longer than the kernel
+ * accepts.
+ */
+static long argumentsSize(char **arguments, const int count)
+{
+    long size, length, longest;
+    int index;
+
+    longest = sysconf(_SC_PAGESIZE) * ARGUMENT_PAGES;
+    size = 0;
+
+    for (index = 0; index < count; index++)
+    {
+        length = strlen(arguments[index]) + 1;
+
+        if (length > longest)
+        {
+            return -1;
+        }
+
+        size += length + sizeof(char *);
+    }
+
+    return size;
+}
+
+/**
+ * Compute the space left for the arguments of a command by its environment
+ * within the limit of `execve()`, which is a quarter of the stack size.
+ *
+ * @param environment The `NULL` terminated array of exported variables.
+ * @return The size in bytes.
+ */
+static long argumentSpace(char **environment)
+{
+    return sysconf(_SC_ARG_MAX) - argumentsSize(environment, countArguments(environment)) - ARGUMENT_HEADROOM;
+}
+
+/**
+ * Execute a series of commands specified in the given command line structure.
+ *
+ * @param line A data structure representing a command line with multiple
+ * commands.
+ * @param shell A pointer to the structure representing the shell state, whose
+ * list of jobs is updated if the command line is executed in background or
+ * stopped, and whose exported variables make up the environment of the
+ * commands.
+ * @param buffer A buffer where the command line instruction is stored.
+ * @param prefix A pointer to the resource limits and processors set by every
+ * child before executing its command, or NULL.
+ * @return The exit status of the last command, `SIGNAL_STATUS` plus the
+ * stop signal if the command line was stopped, `SPAWN_FAILURE` if not every
+ * command could be started, or `EXIT_SUCCESS` if it is executed in
+ * background.
+ *
+ * Take a `tline` command line structure as input and starts all of its
+ * commands at once, connecting each one to the next through a pipe. Every
+ * redirection is done by the children, so the standard file descriptors of
+ * the shell are never modified. Commands without redirections are handed to
+ * a zygote if there is one ready, so the shell only has to send it the
+ * arguments and the standard files of the command, and the pool is refilled
+ * while the command line runs. Commands with prefixes are always forked,
+ * since zygotes do not receive their settings. All the commands are placed in a new process
+ * group, named after the first one, so the whole job can be signalled with a
+ * single `killpg()` and `Ctrl+C` or `Ctrl+Z` only reach the job owning the
+ * terminal. Also updates the `jobs` data structure if the command line is
+ * executed in background, or waits for every command otherwise. Creating a
+ * child is retried while the system is out of processes, and if
+ * `MSH_MAXIMUM_CHILDREN` is set, every command first waits until fewer
+ * commands than that are running.
+ *
+ * Note:
+ *   This function relies on the `parser.h` library and auxiliary functions
+ *   like `redirect` and `run`, and assumes the existence of constants like
+ *   `PIPE_READ`, `PIPE_WRITE`, etc.
+ */
+static int executeExternalCommands(const tline *line, tshell *shell, const char buffer[], const tprefix *prefix)
+{
+    cpu_set_t cpus[MAXIMUM_PID_LIST_SIZE];
+    tpolicy policy;
+    const char *value;
+    char **environment;
+    char **arguments;
+    long size;
+    int commands, command;
+    int maximum;
+    int first, last, background;
+    int input;
+    pid_t pid, pgid;
+    int p[PIPE];
+    int files[STANDARD_FILES];
+    int index;
+    int stopSignal;
+    tjob *currentJob;
+    tjobs *jobs;
+
+    commands = line->ncommands;
+    background = line->background == 1;
+    jobs = &shell->jobs;
+
+    // Shared by every child, only rebuilt when an export changed
+    environment = exportedEnvironment(&shell->variables);
+
+    // Read for every job, so the policy can be changed from the shell
+    if (background)
+    {
+        readPolicy(&shell->variables, &policy);
+    }
+
+    value = getVariable(&shell->variables, MAXIMUM_CHILDREN, strlen(MAXIMUM_CHILDREN));
+    maximum = value != NULL ? atoi(value) : 0;
+
+    // The kernel would refuse these arguments, so nothing is started
+    for (command = 0; command < commands; command++)
+    {
+        arguments = line->commands[command].argv;
+
+        if (arguments[COMMAND] == NULL || findBuiltin(&shell->builtins, arguments[COMMAND]) != NULL || strcmp(arguments[COMMAND], PARALLEL) == 0 || (command == 0 && prefix != NULL && prefix->batch.jobs > 0))
+        {
+            continue;
+        }
+
+        size = argumentsSize(arguments, countArguments(arguments));
+
+        if (size < 0 || size > argumentSpace(environment))
+        {
+            fprintf(stderr, "%s: Error. Argument list too long, it can be split with batch\n", arguments[COMMAND]);
+            return CANNOT_EXECUTE;
+        }
+    }
+
+    // Loaded builtins flush the output of the child before exiting, which
+    // would write again whatever the shell left buffered
+    fflush(stdout);
+
+    currentJob = background ? &jobs->list[jobs->size] : &shell->foreground;
+
+    strcpy(currentJob->instruction, buffer);
+    currentJob->size = 0;
+    currentJob->finished = 0;
+    currentJob->stopped = 0;
+    currentJob->orphans = 0;
+    memset(&currentJob->orphanUsage, 0, sizeof(struct rusage));
+    currentJob->callback = NULL;
+    createCgroup(currentJob, jobs);
+
+    currentJob->placement = PIN_NONE;
+    currentJob->domain = -1;
+    currentJob->pipefail = shell->pipefail;
+
+    if (prefix != NULL && prefix->placement.mode != PIN_NONE)
+    {
+        placeJob(&prefix->placement, currentJob, shell, cpus, commands);
+    }
+
+    // Read end of the pipe connected to the previous command
+    input = NO_FILE;
+    pgid = 0;
+    pid = 0;
+
+    // The whole line is admitted at once, since a line holding some of its
+    // commands could otherwise wait for jobs that wait for it
+    admit(currentJob, jobs, maximum, commands);
+
+    for (command = 0; command < commands; command++)
+    {
+        first = command == 0;
+        last = command == commands - 1;
+
+        p[PIPE_READ] = NO_FILE;
+        p[PIPE_WRITE] = NO_FILE;
+
+        if (!last && pipe(p) != 0)
+        {
+            fprintf(stderr, "pipe: Error. %s\n", strerror(errno));
+            break;
+        }
+
+        pid = -1;
+
+        if (shell->zygotes.size > 0 && line->commands[command].argv[COMMAND] != NULL && findBuiltin(&shell->builtins, line->commands[command].argv[COMMAND]) == NULL && strcmp(line->commands[command].argv[COMMAND], PARALLEL) != 0 && prefix == NULL && currentJob->cgroup < 0 && line->redirect_input == NULL && line->redirect_output == NULL && line->redirect_error == NULL)
+        {
+            files[STDIN_FILENO] = input != NO_FILE ? input : shell->files[STDIN_FILENO];
+            files[STDOUT_FILENO] = !last ? p[PIPE_WRITE] : shell->files[STDOUT_FILENO];
+            files[STDERR_FILENO] = shell->files[STDERR_FILENO];
+
+            pid = launch(&shell->zygotes, line->commands[command].argv, environment, files, shell->mask, background ? &policy : NULL, pgid, !background && shell->interactive && first);
+        }
+
+        if (pid < 0)
+        {
+            pid = retrySpawn(currentJob, jobs);
+        }
+
+        if (pid < 0)
+        {
+            fprintf(stderr, "fork: Error. %s\n", strerror(errno));
+
+            if (!last)
+            {
+                close(p[PIPE_READ]);
+                close(p[PIPE_WRITE]);
+            }
+
+            break;
+        }
+
+        if (pid == FORK_CHILD)
+        {
+            // The input buffered by the shell is not the input of the
+            // command, and exiting before the exec would rewind the offset
+            // shared with the shell to reread it
+            __fpurge(stdin);
+
+            // Done by both the child and the shell, whichever runs first
+            setpgid(0, pgid);
+
+            if (!background && shell->interactive && first)
+            {
+                tcsetpgrp(TERMINAL, getpid());
+            }
+
+            resetSignals();
+            umask(shell->mask);
+
+            if (prefix != NULL && applyLimits(&prefix->limits, "limit") != EXIT_SUCCESS)
+            {
+                leave(EXIT_FAILURE);
+            }
+
+            if (currentJob->placement != PIN_NONE && sched_setaffinity(0, sizeof(cpu_set_t), &cpus[command]) != 0)
+            {
+                fprintf(stderr, "pin: Error. %s\n", strerror(errno));
+                leave(EXIT_FAILURE);
+            }
+
+            if (background)
+            {
+                applyPolicy(&policy, 0);
+            }
+
+            // Standard files chosen by the program embedding the shell
+            for (index = 0; index < STANDARD_FILES; index++)
+            {
+                if (shell->files[index] != index)
+                {
+                    dup2(shell->files[index], index);
+                }
+            }
+
+            if (redirect(line, first, last) != EXIT_SUCCESS)
+            {
+                leave(EXIT_FAILURE);
+            }
+
+            // Reads from the previous command and writes to the next one
+            if (input != NO_FILE)
+            {
+                dup2(input, STDIN_FILENO);
+                close(input);
+            }
+
+            if (!last)
+            {
+                close(p[PIPE_READ]);
+                dup2(p[PIPE_WRITE], STDOUT_FILENO);
+                close(p[PIPE_WRITE]);
+            }
+
+            // The first command runs its batches instead of its program
+            if (first && prefix != NULL && prefix->batch.jobs > 0 && findBuiltin(&shell->builtins, line->commands[command].argv[COMMAND]) == NULL)
+            {
+                leave(runBatches(line->commands[command].argv, environment, &prefix->batch));
+            }
+
+            if (prefix != NULL && prefix->graph.size > 0 && command == prefix->graph.stage)
+            {
+                leave(runGraph(&prefix->graph, shell, environment));
+            }
+
+            if (prefix != NULL && prefix->stages.instances[command] > 1)
+            {
+                leave(runInstances(line, command, environment, &shell->builtins, prefix->stages.instances[command], prefix->stages.modes[command]));
+            }
+
+            // The items are scheduled by the child, without another program
+            if (line->commands[command].argv[COMMAND] != NULL && strcmp(line->commands[command].argv[COMMAND], PARALLEL) == 0 && findBuiltin(&shell->builtins, PARALLEL) == NULL)
+            {
+                leave(mshparallel(line->commands[command].argv, environment));
+            }
+
+            run(line, command, environment, &shell->builtins);
+        }
+
+        if (first)
+        {
+            pgid = pid;
+        }
+
+        setpgid(pid, pgid);
+
+        // The parent keeps no pipe end but the one the next command reads
+        if (input != NO_FILE)
+        {
+            close(input);
+        }
+
+        if (!last)
+        {
+            close(p[PIPE_WRITE]);
+            input = p[PIPE_READ];
+        }
+
+        addProcess(currentJob, command, pid);
+        currentJob->size++;
+    }
+
+    currentJob->pgid = pgid;
+
+    // The commands already started would wait forever on pipes the missing
+    // ones never open, so the partial command line is killed and reaped
+    // instead of being recorded as a job
+    if (command < commands)
+    {
+        if (input != NO_FILE)
+        {
+            close(input);
+        }
+
+        for (index = 0; index < currentJob->size; index++)
+        {
+            if (!currentJob->processes[index].reaped)
+            {
+                kill(currentJob->processes[index].pid, SIGKILL);
+            }
+        }
+
+        if (currentJob->size > 0)
+        {
+            waitJob(currentJob, shell, 0);
+        }
+
+        releaseCgroup(currentJob, jobs);
+
+        return SPAWN_FAILURE;
+    }
+
+    if (background)
+    {
+        jobs->size = (jobs->size + 1) % MAXIMUM_JOB_LIST_SIZE;
+
+        printf("[%i] %i\n", jobs->size, pid);
+
+        return EXIT_SUCCESS;
+    }
+
+    stopSignal = waitJob(currentJob, shell, 0);
+
+    if (stopSignal != 0)
+    {
+        stop(currentJob, jobs);
+        return SIGNAL_STATUS + stopSignal;
+    }
+
+    releaseCgroup(currentJob, jobs);
+
+    return jobStatus(currentJob);
+}
+
+/**
+ * Create the pool of zygotes and start them.
+ *
+ * @param zygotes A pointer to the structure representing the pool.
+ * @param capacity The number of zygotes to be kept ready, 0 to disable them.
+ */
+static void initializeZygotes(tzygotes *zygotes, const int capacity)
+{
+    zygotes->size = 0;
+    zygotes->capacity = capacity < 0 ? 0 : capacity > MAXIMUM_ZYGOTES ? MAXIMUM_ZYGOTES : capacity;
+
+    fillZygotes(zygotes);
+}
+
+/**
+ * Start zygotes until the pool is full.
+ *
+ * Each zygote is a child of the shell connected to it through a socket, so
+ * once it executes a command the shell waits for it like for any other
+ * child. A zygote closes the sockets of the other zygotes right away, so each
+ * of them sees the end of its socket as soon as the shell closes it.
+ *
+ * @param zygotes A pointer to the structure representing the pool.
+ */
+static void fillZygotes(tzygotes *zygotes)
+{
+    int sockets[2];
+    pid_t pid;
+    int index;
+
+    while (zygotes->size < zygotes->capacity)
+    {
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) != 0)
+        {
+            return;
+        }
+
+        pid = fork();
+
+        if (pid == FORK_CHILD)
+        {
+            for (index = 0; index < zygotes->size; index++)
+            {
+                close(zygotes->sockets[index]);
+            }
+
+            close(sockets[0]);
+            zygote(sockets[1]);
+        }
+
+        close(sockets[1]);
+
+        if (pid < 0)
+        {
+            close(sockets[0]);
+            return;
+        }
+
+        zygotes->pids[zygotes->size] = pid;
+        zygotes->sockets[zygotes->size] = sockets[0];
+        zygotes->size++;
+    }
+}
+
+/**
+ * Stop every zygote of the pool by closing its socket.
+ *
+ * @param zygotes A pointer to the structure representing the pool.
+ */
+static void closeZygotes(tzygotes *zygotes)
+{
+    emptyZygotes(zygotes);
+    zygotes->capacity = 0;
+}
+
+/**
+ * Stop the zygotes ready in the pool and wait for them, so the pool is
+ * refilled with zygotes forked from the current state of the shell.
+ *
+ * Called when the shell changes a state the zygotes inherited when they
+ * were forked and do not receive with each request, such as its resource
+ * limits.
+ *
+ * @param zygotes A pointer to the structure representing the pool.
+ */
+static void emptyZygotes(tzygotes *zygotes)
+{
+    int index;
+
+    for (index = 0; index < zygotes->size; index++)
+    {
+        close(zygotes->sockets[index]);
+    }
+
+    // Each zygote exits as soon as it sees the end of its socket
+    for (index = 0; index < zygotes->size; index++)
+    {
+        while (waitpid(zygotes->pids[index], NULL, 0) < 0 && errno == EINTR)
+        {
+        }
+    }
+
+    zygotes->size = 0;
+}
+
+/**
+ * Execute a command in a zygote of the pool.
+ *
+ * The request carries the arguments, the environment, the file creation
+ * mask and the background policy of the command, and its standard files and the working directory of
+ * the shell are passed as `SCM_RIGHTS` ancillary data, so the zygote
+ * receives its own copy of them. The zygote was forked before the last `cd`
+ * or `umask`, so it takes both from the request rather than from its own
+ * state.
+ *
+ * @param zygotes A pointer to the structure representing the pool.
+ * @param arguments The `NULL` terminated array of arguments of the command.
+ * @param environment The `NULL` terminated array of exported variables.
+ * @param files The standard input, output and error of the command.
+ * @param mask The file creation mask of the command.
+ * @param policy A pointer to the policy applied to the command, or `NULL` for
+ * none.
+ * @param pgid The process group the command joins, or 0 for a new one.
+ * @param terminal Flag indicating whether the command takes the terminal.
+ * @return The process identifier of the command, or -1 if the request could
+ * not be sent, in which case the command must be forked instead.
+ */
+static pid_t launch(tzygotes *zygotes, char **arguments, char **environment, const int files[], const mode_t mask, const tpolicy *policy, const pid_t pgid, const int terminal)
+{
+    char control[CMSG_SPACE(sizeof(int) * ZYGOTE_FILES)];
+    int descriptors[ZYGOTE_FILES];
+    tzygoterequest request;
+    struct msghdr message;
+    struct cmsghdr *header;
+    struct iovec vector;
+    tarena strings;
+    ssize_t sent;
+    int socket;
+    pid_t pid;
+    int index;
+
+    descriptors[STANDARD_FILES] = open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    if (descriptors[STANDARD_FILES] < 0)
+    {
+        return -1;
+    }
+
+    memcpy(descriptors, files, sizeof(int) * STANDARD_FILES);
+
+    zygotes->size--;
+    socket = zygotes->sockets[zygotes->size];
+    pid = zygotes->pids[zygotes->size];
+
+    strings.data = NULL;
+    strings.size = 0;
+    strings.capacity = 0;
+
+    for (index = 0; arguments[index] != NULL; index++)
+    {
+        append(&strings, arguments[index], strlen(arguments[index]) + 1);
+    }
+
+    request.arguments = index;
+
+    for (index = 0; environment[index] != NULL; index++)
+    {
+        append(&strings, environment[index], strlen(environment[index]) + 1);
+    }
+
+    request.pgid = pgid;
+    request.terminal = terminal;
+    request.mask = mask;
+    request.size = strings.size;
+
+    if (policy != NULL)
+    {
+        request.policy = *policy;
+    }
+    else
+    {
+        request.policy.nice = NO_POLICY;
+        request.policy.scheduler = NO_POLICY;
+        request.policy.ioClass = NO_POLICY;
+        request.policy.ioLevel = 0;
+    }
+
+    vector.iov_base = &request;
+    vector.iov_len = sizeof(request);
+
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(int) * ZYGOTE_FILES);
+    memcpy(CMSG_DATA(header), descriptors, sizeof(int) * ZYGOTE_FILES);
+
+    do
+    {
+        sent = sendmsg(socket, &message, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+
+    // A zygote that died is dropped and reaped, and the command is forked
+    // instead
+    if (sent != sizeof(request) || !transfer(socket, strings.data, strings.size, 1))
+    {
+        kill(pid, SIGKILL);
+
+        while (waitpid(pid, NULL, 0) < 0 && errno == EINTR)
+        {
+        }
+
+        pid = -1;
+    }
+
+    close(socket);
+    close(descriptors[STANDARD_FILES]);
+    free(strings.data);
+
+    return pid;
+}
+
+/**
+ * Main loop of a zygote, which waits for a single request and executes the
+ * command it carries with the standard files received along with it.
+ *
+ * The zygote moves to a process group of its own, so signals sent from the
+ * terminal to the shell do not reach it while it waits. If the shell closes
+ * the socket without sending a request, the zygote exits. It always exits
+ * with `_exit()`, so it never flushes the output the shell had buffered when
+ * it was forked.
+ *
+ * @param socket The end of the socket connected to the shell.
+ */
+static void zygote(int socket)
+{
+    char control[CMSG_SPACE(sizeof(int) * ZYGOTE_FILES)];
+    int files[ZYGOTE_FILES];
+    tzygoterequest request;
+    struct msghdr message;
+    struct cmsghdr *header;
+    struct iovec vector;
+    char **arguments;
+    char **environment;
+    char *strings;
+    char *cursor;
+    ssize_t received;
+    int count;
+    int index;
+
+    setpgid(0, 0);
+
+    vector.iov_base = &request;
+    vector.iov_len = sizeof(request);
+
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    do
+    {
+        received = recvmsg(socket, &message, MSG_WAITALL | MSG_CMSG_CLOEXEC);
+    } while (received < 0 && errno == EINTR);
+
+    header = CMSG_FIRSTHDR(&message);
+
+    if (received != sizeof(request) || header == NULL || header->cmsg_type != SCM_RIGHTS)
+    {
+        _exit(EXIT_SUCCESS);
+    }
+
+    memcpy(files, CMSG_DATA(header), sizeof(int) * ZYGOTE_FILES);
+
+    strings = malloc(request.size);
+
+    if (!transfer(socket, strings, request.size, 0))
+    {
+        _exit(EXIT_FAILURE);
+    }
+
+    close(socket);
+
+    if (request.pgid != 0)
+    {
+        setpgid(0, request.pgid);
+    }
+
+    // The zygote may have been forked before the shell ignored `SIGTTOU`,
+    // and taking the terminal from a background group would stop it
+    if (request.terminal)
+    {
+        signal(SIGTTOU, SIG_IGN);
+        tcsetpgrp(TERMINAL, getpgrp());
+    }
+
+    resetSignals();
+
+    // The state of the shell when the command was launched, not when the
+    // zygote was forked
+    if (fchdir(files[STANDARD_FILES]) != 0)
+    {
+        fprintf(stderr, "cd: Error. %s\n", strerror(errno));
+        _exit(EXIT_FAILURE);
+    }
+
+    umask(request.mask);
+
+    // Before the exec, so the command never runs at the priority of the shell
+    applyPolicy(&request.policy, 0);
+
+    // The received files are closed on execution, their copies are not
+    for (index = 0; index < STANDARD_FILES; index++)
+    {
+        dup2(files[index], index);
+    }
+
+    count = 0;
+
+    for (cursor = strings; cursor < strings + request.size; cursor += strlen(cursor) + 1)
+    {
+        count++;
+    }
+
+    arguments = malloc(sizeof(char *) * (request.arguments + 1));
+    environment = malloc(sizeof(char *) * (count - request.arguments + 1));
+
+    cursor = strings;
+
+    for (index = 0; index < count; index++)
+    {
+        if (index < request.arguments)
+        {
+            arguments[index] = cursor;
+        }
+        else
+        {
+            environment[index - request.arguments] = cursor;
+        }
+
+        cursor += strlen(cursor) + 1;
+    }
+
+    arguments[request.arguments] = NULL;
+    environment[count - request.arguments] = NULL;
+
+    execvpe(arguments[COMMAND], arguments, environment);
+
+    fprintf(stderr, "%s: Command not found\n", arguments[COMMAND]);
+    _exit(COMMAND_NOT_FOUND);
+}
+
+/**
+ * Send or receive a given number of bytes through a socket, retrying after
+ * partial transfers and interruptions.
+ *
+ * @param socket The socket.
+ * @param data The bytes to be sent, or the buffer where they are received.
+ * @param size The number of bytes.
+ * @param sending Flag indicating whether the bytes are sent.
+ * @return 1 if every byte was transferred, 0 otherwise.
+ */
+static int transfer(int socket, char *data, int size, const int sending)
+{
+    ssize_t bytes;
+
+    while (size > 0)
+    {
+        bytes = sending ? send(socket, data, size, MSG_NOSIGNAL) : recv(socket, data, size, 0);
+
+        if (bytes < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (bytes <= 0)
+        {
+            return 0;
+        }
+
+        data += bytes;
+        size -= bytes;
+    }
+
+    return 1;
+}
+
+/**
+ * Measure how many times per second a command can be executed by forking
+ * the shell and by handing it to a zygote.
+ *
+ * The command is executed the given number of times in foreground with
+ * each method, and the rate of each one is printed. If zygotes are disabled,
+ * a pool of `DEFAULT_ZYGOTES` is started for the measure. The pool is
+ * refilled between executions, out of the measured time, as it is while the
+ * shell waits at the prompt.
+ *
+ * Example:
+ *   benchmark 1000 true
+ *
+ * @param arguments The `NULL` terminated array of arguments of the command,
+ * made of the number of executions and the command to be measured.
+ * @param shell A pointer to the structure representing the shell state.
+ * @return `EXIT_SUCCESS`, or `EXIT_FAILURE` if the arguments are not valid.
+ */
+static int mshbenchmark(char **arguments, tshell *shell)
+{
+    char command[MAXIMUM_LINE_LENGTH];
+    struct timespec start, end;
+    tzygotes zygotes;
+    long long elapsed[2];
+    int runs, run, method;
+    int index, length;
+
+    if (arguments[1] == NULL || arguments[2] == NULL || (runs = atoi(arguments[1])) <= 0)
+    {
+        fprintf(stderr, "benchmark: Error. Usage: benchmark COUNT COMMAND [ARGUMENTS]\n");
+        return EXIT_FAILURE;
+    }
+
+    length = 0;
+
+    for (index = 2; arguments[index] != NULL && length < MAXIMUM_LINE_LENGTH - 1; index++)
+    {
+        length += snprintf(command + length, MAXIMUM_LINE_LENGTH - length, index == 2 ? "%s" : " %s", arguments[index]);
+    }
+
+    snprintf(command + length, MAXIMUM_LINE_LENGTH - length, "\n");
+
+    zygotes = shell->zygotes;
+
+    for (method = 0; method < 2; method++)
+    {
+        if (method == 0)
+        {
+            shell->zygotes.size = 0;
+            shell->zygotes.capacity = 0;
+        }
+        else if (zygotes.capacity > 0)
+        {
+            shell->zygotes = zygotes;
+        }
+        else
+        {
+            initializeZygotes(&shell->zygotes, DEFAULT_ZYGOTES);
+        }
+
+        elapsed[method] = 0;
+
+        for (run = 0; run < runs; run++)
+        {
+            fillZygotes(&shell->zygotes);
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            executeLine(command, shell);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+
+            elapsed[method] += (end.tv_sec - start.tv_sec) * NANOSECONDS + end.tv_nsec - start.tv_nsec;
+        }
+    }
+
+    if (zygotes.capacity == 0)
+    {
+        closeZygotes(&shell->zygotes);
+    }
+
+    for (method = 0; method < 2; method++)
+    {
+        printf("%s: %i commands in %lli ms, %.1f commands/s\n", method == 0 ? "fork" : "zygote", runs, elapsed[method] / 1000000,
+               runs * (double)NANOSECONDS / (elapsed[method] > 0 ? elapsed[method] : 1));
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Serve command lines received on a Unix domain socket, so clients do not
+ * have to start a shell for each of them.
+ *
+ * Every client is handled by a child of the server, so many clients are
+ * served at once, and each child starts from the variables of the server
+ * without reading the environment again. Finished children are discarded
+ * by the kernel, since the server ignores `SIGCHLD`. When no more clients
+ * can be accepted for lack of file descriptors or memory, the server waits
+ * for `ACCEPT_RETRY_INTERVAL` milliseconds before trying again.
+ *
+ * @param shell A pointer to the structure representing the shell state.
+ * @param path The path of the socket, which is replaced if it exists.
+ * @return `EXIT_FAILURE` if the socket could not be created or clients can
+ * no longer be accepted, since the server never returns otherwise.
+ */
+int msh_serve(msh_context *shell, const char *path)
+{
+    struct sockaddr_un address;
+    int server, client;
+    pid_t pid;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+        fprintf(stderr, "%s: Error. %s\n", path, strerror(ENAMETOOLONG));
+        return EXIT_FAILURE;
+    }
+
+    strcpy(address.sun_path, path);
+    unlink(path);
+
+    server = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+
+    if (server < 0 || bind(server, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(server, SOMAXCONN) != 0)
+    {
+        fprintf(stderr, "%s: Error. %s\n", path, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    signal(SIGCHLD, SIG_IGN);
+
+    for (;;)
+    {
+        client = accept4(server, NULL, NULL, SOCK_CLOEXEC);
+
+        if (client < 0 && (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM))
+        {
+            poll(NULL, 0, ACCEPT_RETRY_INTERVAL);
+            continue;
+        }
+
+        // Clients that left before being accepted are not an error
+        if (client < 0 && (errno == EINTR || errno == ECONNABORTED))
+        {
+            continue;
+        }
+
+        if (client < 0)
+        {
+            fprintf(stderr, "%s: Error. %s\n", path, strerror(errno));
+            close(server);
+            return EXIT_FAILURE;
+        }
+
+        fflush(stdout);
+        pid = fork();
+
+        if (pid == FORK_CHILD)
+        {
+            close(server);
+            signal(SIGCHLD, SIG_DFL);
+
+            // The zygotes are children of the server, not of this process
+            closeZygotes(&shell->zygotes);
+
+            leave(session(client, shell));
+        }
+
+        close(client);
+    }
+}
+
+/**
+ * Execute the command lines sent by a client of the server until it closes
+ * the connection.
+ *
+ * Once connected, the client receives a message holding `output` and the
+ * read end of a pipe as `SCM_RIGHTS` ancillary data. Every request is a
+ * single message holding a command line, optionally along with the standard
+ * input, output and error of its commands. Without them, the commands read
+ * from `/dev/null` and write to that pipe, which the client must drain while
+ * waiting for the response. Only the session itself writes to the socket,
+ * so no output can be taken for a response. Once the command line finishes,
+ * a message with its exit status and the resources used by its children is
+ * sent back. Background jobs keep running after the client leaves, unless
+ * it ends the session with `exit`.
+ *
+ * The user and system times are the ones of the children reaped while the
+ * request ran, which includes background jobs of earlier requests that
+ * finished meanwhile. The maximum resident set size is the largest of every
+ * child reaped so far, as reported by `getrusage(RUSAGE_CHILDREN)`, not the
+ * one of this request alone.
+ *
+ * Requests whose line or ancillary data were truncated, or carrying a number
+ * of files other than three, are not executed: every file they carried is
+ * closed and the response is an error instead.
+ *
+ * Example responses:
+ *   status 0 user 0.001204 system 0.000000 maxrss 1624
+ *   error Message too long
+ *
+ * @param client The socket connected to the client.
+ * @param shell A pointer to the structure representing the shell state.
+ * @return `EXIT_SUCCESS` once the client closes the connection or executes
+ * `exit`.
+ */
+static int session(int client, tshell *shell)
+{
+    char control[CMSG_SPACE(sizeof(int) * STANDARD_FILES)];
+    char buffer[MAXIMUM_LINE_LENGTH];
+    char response[RESPONSE_SIZE];
+    int files[STANDARD_FILES];
+    int descriptors[STANDARD_FILES];
+    int output[PIPE];
+    struct rusage before, after;
+    struct msghdr message;
+    struct cmsghdr *header;
+    struct iovec vector;
+    ssize_t received;
+    int empty;
+    int status;
+    int index;
+    int length;
+    int count, size, error, file;
+
+    empty = open("/dev/null", FILE_READ | O_CLOEXEC);
+
+    if (pipe2(output, O_CLOEXEC) != 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    // The session keeps the write end only
+    status = offer(client, OUTPUT_GREETING, output[PIPE_READ]);
+    close(output[PIPE_READ]);
+
+    if (!status)
+    {
+        return EXIT_SUCCESS;
+    }
+
+    for (;;)
+    {
+        vector.iov_base = buffer;
+        vector.iov_len = MAXIMUM_LINE_LENGTH - 2;
+
+        memset(&message, 0, sizeof(message));
+        message.msg_iov = &vector;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+
+        received = recvmsg(client, &message, MSG_CMSG_CLOEXEC);
+
+        if (received < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (received <= 0)
+        {
+            return EXIT_SUCCESS;
+        }
+
+        // Every file received is either used by the commands or closed
+        count = 0;
+
+        for (header = CMSG_FIRSTHDR(&message); header != NULL; header = CMSG_NXTHDR(&message, header))
+        {
+            if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS)
+            {
+                continue;
+            }
+
+            size = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+
+            for (index = 0; index < size; index++, count++)
+            {
+                memcpy(&file, CMSG_DATA(header) + sizeof(int) * index, sizeof(int));
+
+                if (count < STANDARD_FILES)
+                {
+                    descriptors[count] = file;
+                }
+                else
+                {
+                    close(file);
+                }
+            }
+        }
+
+        error = 0;
+
+        if ((message.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) != 0)
+        {
+            error = EMSGSIZE;
+        }
+        else if (count > 0 && count != STANDARD_FILES)
+        {
+            error = EINVAL;
+        }
+
+        if (error != 0)
+        {
+            for (index = 0; index < count && index < STANDARD_FILES; index++)
+            {
+                close(descriptors[index]);
+            }
+
+            length = snprintf(response, RESPONSE_SIZE, "error %s\n", strerror(error));
+
+            if (send(client, response, length, MSG_NOSIGNAL) < 0)
+            {
+                return EXIT_SUCCESS;
+            }
+
+            continue;
+        }
+
+        // Every line reaches the parser ending in a newline, as read by `fgets()`
+        if (buffer[received - 1] != '\n')
+        {
+            buffer[received++] = '\n';
+        }
+
+        buffer[received] = '\0';
+
+        if (count == STANDARD_FILES)
+        {
+            memcpy(files, descriptors, sizeof(int) * STANDARD_FILES);
+        }
+        else
+        {
+            files[STDIN_FILENO] = empty;
+            files[STDOUT_FILENO] = output[PIPE_WRITE];
+            files[STDERR_FILENO] = output[PIPE_WRITE];
+        }
+
+        for (index = 0; index < STANDARD_FILES; index++)
+        {
+            dup2(files[index], index);
+
+            if (files[index] != empty && files[index] != output[PIPE_WRITE])
+            {
+                close(files[index]);
+            }
+        }
+
+        getrusage(RUSAGE_CHILDREN, &before);
+
+        status = executeList(buffer, shell);
+        reap(&shell->jobs);
+
+        fflush(stdout);
+        getrusage(RUSAGE_CHILDREN, &after);
+
+        timersub(&after.ru_utime, &before.ru_utime, &after.ru_utime);
+        timersub(&after.ru_stime, &before.ru_stime, &after.ru_stime);
+
+        length = snprintf(response, RESPONSE_SIZE, "status %i user %li.%06li system %li.%06li maxrss %li\n", status,
+                          (long)after.ru_utime.tv_sec, (long)after.ru_utime.tv_usec,
+                          (long)after.ru_stime.tv_sec, (long)after.ru_stime.tv_usec, after.ru_maxrss);
+
+        if (send(client, response, length, MSG_NOSIGNAL) < 0 || shell->exited)
+        {
+            return EXIT_SUCCESS;
+        }
+    }
+}
+
+/**
+ * Send a message holding a text and a file descriptor as `SCM_RIGHTS`
+ * ancillary data.
+ *
+ * @param socket The socket the message is sent on.
+ * @param text The text of the message.
+ * @param file The file descriptor, which the caller still owns.
+ * @return 1 if the message was sent, 0 otherwise.
+ */
+static int offer(int socket, const char *text, int file)
+{
+    char control[CMSG_SPACE(sizeof(int))];
+    struct msghdr message;
+    struct cmsghdr *header;
+    struct iovec vector;
+    ssize_t sent;
+
+    vector.iov_base = (char *)text;
+    vector.iov_len = strlen(text);
+
+    memset(&message, 0, sizeof(message));
+    memset(control, 0, sizeof(control));
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(header), &file, sizeof(int));
+
+    do
+    {
+        sent = sendmsg(socket, &message, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+
+    return sent == (ssize_t)vector.iov_len;
+}
+
+/**
+ * Load builtins from a shared object, remove them, or list them.
+ *
+ * With `-f path name...`, the handler of every name is looked up in the
+ * shared object as the `name_builtin` symbol and added to the builtins, so
+ * later command lines run it inside the shell instead of executing a
+ * program. With `-d name...`, the builtins are removed. Without arguments,
+ * the loaded builtins are listed.
+ *
+ * @param arguments The arguments of the command, starting with `enable`.
+ * @param builtins A pointer to the list of loaded builtins.
+ * @return `EXIT_SUCCESS` if every builtin was loaded or removed,
+ * `EXIT_FAILURE` otherwise.
+ */
+static int mshenable(char **arguments, tbuiltins *builtins)
+{
+    char symbol[MAXIMUM_LINE_LENGTH];
+    tbuiltin *builtin;
+    msh_builtin handler;
+    void *library;
+    int index;
+    int status;
+
+    if (arguments[OPTION] == NULL)
+    {
+        for (index = 0; index < builtins->size; index++)
+        {
+            printf("enable %s\n", builtins->list[index].name);
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+    status = EXIT_SUCCESS;
+
+    if (strcmp(arguments[OPTION], REMOVE) == 0)
+    {
+        for (index = OPTION + 1; arguments[index] != NULL; index++)
+        {
+            builtin = findBuiltin(builtins, arguments[index]);
+
+            if (builtin == NULL)
+            {
+                fprintf(stderr, "%s: Error. Not a loaded builtin\n", arguments[index]);
+                status = EXIT_FAILURE;
+                continue;
+            }
+
+            removeBuiltin(builtin, builtins);
+        }
+
+        return status;
+    }
+
+    if (strcmp(arguments[OPTION], LOAD) != 0 || arguments[LIBRARY] == NULL || arguments[NAMES] == NULL)
+    {
+        fprintf(stderr, "enable: Error. Usage: enable [-f library name... | -d name...]\n");
+        return EXIT_FAILURE;
+    }
+
+    for (index = NAMES; arguments[index] != NULL; index++)
+    {
+        // Every builtin holds its own reference, so removing one of them
+        // keeps the others of the same library loaded
+        library = dlopen(arguments[LIBRARY], RTLD_NOW | RTLD_LOCAL);
+        if (library == NULL)
+        {
+            fprintf(stderr, "enable: Error. %s\n", dlerror());
+            return EXIT_FAILURE;
+        }
+
+        snprintf(symbol, MAXIMUM_LINE_LENGTH, "%s%s", arguments[index], BUILTIN_SUFFIX);
+        handler = (msh_builtin)dlsym(library, symbol);
+
+        if (handler == NULL)
+        {
+            fprintf(stderr, "%s: Error. %s\n", arguments[index], dlerror());
+            dlclose(library);
+            status = EXIT_FAILURE;
+            continue;
+        }
+
+        builtin = findBuiltin(builtins, arguments[index]);
+        if (builtin != NULL)
+        {
+            removeBuiltin(builtin, builtins);
+        }
+
+        if (builtins->size == MAXIMUM_BUILTINS)
+        {
+            fprintf(stderr, "%s: Error. Too many builtins\n", arguments[index]);
+            dlclose(library);
+            status = EXIT_FAILURE;
+            continue;
+        }
+
+        builtin = &builtins->list[builtins->size++];
+        builtin->name = strdup(arguments[index]);
+        builtin->handler = handler;
+        builtin->library = library;
+    }
+
+    return status;
+}
+
+/**
+ * Find a builtin loaded from a shared object.
+ *
+ * @param builtins A pointer to the list of loaded builtins.
+ * @param name The name of the builtin.
+ * @return A pointer to the builtin, or NULL if it is not loaded.
+ */
+static tbuiltin *findBuiltin(tbuiltins *builtins, const char *name)
+{
+    int index;
+
+    if (name == NULL)
+    {
+        return NULL;
+    }
+
+    for (index = 0; index < builtins->size; index++)
+    {
+        if (strcmp(builtins->list[index].name, name) == 0)
+        {
+            return &builtins->list[index];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Remove a loaded builtin, releasing its reference to the shared object.
+ *
+ * @param builtin A pointer to the builtin, which is overwritten by the last
+ * one of the list.
+ * @param builtins A pointer to the list of loaded builtins.
+ */
+static void removeBuiltin(tbuiltin *builtin, tbuiltins *builtins)
+{
+    free(builtin->name);
+    dlclose(builtin->library);
+
+    *builtin = builtins->list[--builtins->size];
+}
+
+/**
+ * Run a loaded builtin inside the shell, without forking.
+ *
+ * The standard files of the shell are duplicated, replaced by the ones of
+ * the embedding program and the redirections of the line, and restored once
+ * the handler returns, so the builtin sees the same files as an external
+ * command would. The file creation mask of the shell is applied meanwhile
+ * in the same way.
+ *
+ * @param line A pointer to a `tline` structure holding a single command.
+ * @param handler The function executing the builtin.
+ * @param shell A pointer to the structure representing the shell state.
+ * @return The exit status of the builtin, or `EXIT_FAILURE` if a redirection
+ * failed.
+ */
+static int runBuiltin(const tline *line, msh_builtin handler, tshell *shell)
+{
+    int saved[STANDARD_FILES];
+    char **arguments;
+    mode_t mask;
+    int index;
+    int status;
+
+    arguments = line->commands[COMMAND].argv;
+
+    fflush(stdout);
+    fflush(stderr);
+
+    for (index = 0; index < STANDARD_FILES; index++)
+    {
+        saved[index] = fcntl(index, F_DUPFD_CLOEXEC, STANDARD_FILES);
+
+        if (shell->files[index] != index)
+        {
+            dup2(shell->files[index], index);
+        }
+    }
+
+    mask = umask(shell->mask);
+    status = redirect(line, 1, 1);
+
+    if (status == EXIT_SUCCESS)
+    {
+        status = handler(countArguments(arguments), arguments, exportedEnvironment(&shell->variables));
+    }
+
+    // Whatever the builtin left buffered belongs to its redirections
+    fflush(stdout);
+    fflush(stderr);
+
+    for (index = 0; index < STANDARD_FILES; index++)
+    {
+        if (saved[index] < 0)
+        {
+            close(index);
+            continue;
+        }
+
+        dup2(saved[index], index);
+        close(saved[index]);
+    }
+
+    umask(mask);
+
+    return status;
+}
+
+/**
+ * Count the arguments of a command.
+ *
+ * @param arguments The `NULL` terminated array of arguments.
+ * @return The number of arguments, including the command itself.
+ */
+static int countArguments(char **arguments)
+{
+    int count;
+
+    for (count = 0; arguments[count] != NULL; count++)
+    {
+    }
+
+    return count;
+}
+
+/**
+ * Display or set the resource limits of the shell, which are inherited by
+ * every command executed afterwards.
+ *
+ * Every option names a resource, followed by its new value or by nothing to
+ * display it. `-H` and `-S` select the hard or the soft limit; setting a
+ * limit without them changes both, and displaying it shows the soft one.
+ * `-a` displays every limit, and no option at all displays `-f`.
+ *
+ * @param arguments The arguments of the command, starting with `ulimit`.
+ * @param zygotes A pointer to the pool of zygotes, which is emptied when a
+ * limit is set since they keep the limits they were forked with.
+ * @return `EXIT_SUCCESS` if every limit was displayed or set, `EXIT_FAILURE`
+ * otherwise.
+ */
+static int mshulimit(char **arguments, tzygotes *zygotes)
+{
+    tlimits limits;
+    struct rlimit current;
+    rlim_t value;
+    const tlimit *limit;
+    int index;
+
+    limits.size = 0;
+    index = parseLimits(arguments, &limits, 0);
+    if (index < 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (arguments[index] != NULL)
+    {
+        fprintf(stderr, "%s: Error. Invalid limit\n", arguments[index]);
+        return EXIT_FAILURE;
+    }
+
+    if (limits.size == 0)
+    {
+        limits.list[0].resource = findResource('f');
+        limits.list[0].set = 0;
+        limits.list[0].soft = 1;
+        limits.list[0].hard = 0;
+        limits.size = 1;
+    }
+
+    if (applyLimits(&limits, "ulimit") != EXIT_SUCCESS)
+    {
+        return EXIT_FAILURE;
+    }
+
+    for (index = 0; index < limits.size; index++)
+    {
+        limit = &limits.list[index];
+
+        if (limit->set)
+        {
+            emptyZygotes(zygotes);
+            continue;
+        }
+
+        getrlimit(limit->resource->resource, &current);
+        value = limit->soft ? current.rlim_cur : current.rlim_max;
+
+        // Labels are only needed to tell several limits apart
+        if (limits.size > 1)
+        {
+            printf("%-28s(%s-%c) ", limit->resource->description, limit->resource->unit, limit->resource->option);
+        }
+
+        if (value == RLIM_INFINITY)
+        {
+            printf("unlimited\n");
+        }
+        else
+        {
+            printf("%llu\n", (unsigned long long)(value / limit->resource->scale));
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Parse the options of `ulimit` or of a `limit` prefix.
+ *
+ * @param arguments The arguments of the command, starting with its name.
+ * @param limits A pointer to the structure where the limits are appended.
+ * The limits without a value are only meant to be displayed.
+ * @param prefix Flag indicating whether the options are followed by a
+ * command, so every resource needs a value and `-a` is not allowed.
+ * @return The index of the first argument that is not an option, or -1 if
+ * the options are invalid.
+ */
+static int parseLimits(char **arguments, tlimits *limits, const int prefix)
+{
+    const tresource *resource;
+    const char *letter;
+    tlimit *limit;
+    char *option;
+    char *value;
+    int soft;
+    int hard;
+    int index;
+    int first;
+    int all;
+
+    first = limits->size;
+    soft = 0;
+    hard = 0;
+    all = 0;
+
+    for (index = 1; arguments[index] != NULL && arguments[index][0] == '-'; index++)
+    {
+        option = arguments[index];
+        resource = option[1] != '\0' && option[2] == '\0' ? findResource(option[1]) : NULL;
+
+        if (strcmp(option, "-H") == 0)
+        {
+            hard = 1;
+            continue;
+        }
+
+        if (strcmp(option, "-S") == 0)
+        {
+            soft = 1;
+            continue;
+        }
+
+        if (strcmp(option, "-a") == 0 && !prefix)
+        {
+            all = 1;
+            continue;
+        }
+
+        if (resource == NULL)
+        {
+            fprintf(stderr, "%s: Error. Invalid option\n", option);
+            return -1;
+        }
+
+        if (limits->size == MAXIMUM_LIMITS)
+        {
+            fprintf(stderr, "%s: Error. Too many limits\n", option);
+            return -1;
+        }
+
+        limit = &limits->list[limits->size++];
+        limit->resource = resource;
+        limit->set = 0;
+
+        value = arguments[index + 1];
+
+        if (value != NULL && value[0] != '-')
+        {
+            if (parseLimit(value, resource, &limit->value) != EXIT_SUCCESS)
+            {
+                fprintf(stderr, "%s: Error. Invalid limit\n", value);
+                return -1;
+            }
+
+            limit->set = 1;
+            index++;
+        }
+        else if (prefix)
+        {
+            fprintf(stderr, "%s: Error. Missing limit\n", option);
+            return -1;
+        }
+    }
+
+    for (letter = RESOURCES; all && *letter != '\0' && limits->size < MAXIMUM_LIMITS; letter++)
+    {
+        limit = &limits->list[limits->size++];
+        limit->resource = findResource(*letter);
+        limit->set = 0;
+    }
+
+    // Like in other shells, -H and -S apply to every option of the command
+    for (limit = limits->list + first; limit < limits->list + limits->size; limit++)
+    {
+        limit->soft = soft || !hard;
+        limit->hard = hard || (!soft && limit->set);
+    }
+
+    return index;
+}
+
+/**
+ * Parse the value of a resource limit.
+ *
+ * @param text The value: `unlimited`, or a number in the unit displayed by
+ * `ulimit`. Sizes also accept a `K`, `M`, `G` or `T` suffix, which makes the
+ * number a count of bytes multiplied by that power of 1024.
+ * @param resource A pointer to the resource being limited.
+ * @param value A pointer where the value for `setrlimit()` is stored.
+ * @return `EXIT_SUCCESS` if the value is valid, `EXIT_FAILURE` otherwise.
+ */
+static int parseLimit(const char *text, const tresource *resource, rlim_t *value)
+{
+    static const char suffixes[] = "KMGT";
+    unsigned long long number;
+    const char *suffix;
+    char *end;
+
+    if (strcmp(text, "unlimited") == 0)
+    {
+        *value = RLIM_INFINITY;
+        return EXIT_SUCCESS;
+    }
+
+    if (text[0] < '0' || text[0] > '9')
+    {
+        return EXIT_FAILURE;
+    }
+
+    errno = 0;
+    number = strtoull(text, &end, 10);
+
+    if (errno != 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (*end == '\0')
+    {
+        *value = number * resource->scale;
+        return EXIT_SUCCESS;
+    }
+
+    suffix = strchr(suffixes, *end);
+    if (!resource->size || suffix == NULL || end[1] != '\0')
+    {
+        return EXIT_FAILURE;
+    }
+
+    *value = number << (10 * (suffix - suffixes + 1));
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Find a resource by the option of `ulimit` naming it.
+ *
+ * @param option The letter of the option, as in `bash`.
+ * @return A pointer to the resource, or NULL if no resource has that option.
+ */
+static const tresource *findResource(const char option)
+{
+    static const tresource resources[] = {
+        {'c', RLIMIT_CORE, 1024, 1, "core file size", "blocks, "},
+        {'d', RLIMIT_DATA, 1024, 1, "data seg size", "kbytes, "},
+        {'e', RLIMIT_NICE, 1, 0, "scheduling priority", ""},
+        {'f', RLIMIT_FSIZE, 1024, 1, "file size", "blocks, "},
+        {'i', RLIMIT_SIGPENDING, 1, 0, "pending signals", ""},
+        {'l', RLIMIT_MEMLOCK, 1024, 1, "max locked memory", "kbytes, "},
+        {'m', RLIMIT_RSS, 1024, 1, "max memory size", "kbytes, "},
+        {'n', RLIMIT_NOFILE, 1, 0, "open files", ""},
+        {'q', RLIMIT_MSGQUEUE, 1, 1, "POSIX message queues", "bytes, "},
+        {'r', RLIMIT_RTPRIO, 1, 0, "real-time priority", ""},
+        {'s', RLIMIT_STACK, 1024, 1, "stack size", "kbytes, "},
+        {'t', RLIMIT_CPU, 1, 0, "cpu time", "seconds, "},
+        {'u', RLIMIT_NPROC, 1, 0, "max user processes", ""},
+        {'v', RLIMIT_AS, 1024, 1, "virtual memory", "kbytes, "},
+        {'x', RLIMIT_LOCKS, 1, 0, "file locks", ""},
+        {'R', RLIMIT_RTTIME, 1, 0, "real-time non-blocking time", "microseconds, "}};
+    int index;
+
+    for (index = 0; index < (int)(sizeof(resources) / sizeof(resources[0])); index++)
+    {
+        if (resources[index].option == option)
+        {
+            return &resources[index];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Set the resource limits of the calling process that have a value.
+ *
+ * Used by `ulimit` on the shell itself, and by the children of a command
+ * line with a `limit` prefix before executing their command.
+ *
+ * @param limits A pointer to the limits.
+ * @param name The name of the command, for error messages.
+ * @return `EXIT_SUCCESS` if every limit was set, `EXIT_FAILURE` otherwise.
+ */
+static int applyLimits(const tlimits *limits, const char *name)
+{
+    struct rlimit current;
+    const tlimit *limit;
+    int index;
+
+    for (index = 0; index < limits->size; index++)
+    {
+        limit = &limits->list[index];
+
+        if (!limit->set)
+        {
+            continue;
+        }
+
+        getrlimit(limit->resource->resource, &current);
+
+        if (limit->soft)
+        {
+            current.rlim_cur = limit->value;
+        }
+
+        if (limit->hard)
+        {
+            current.rlim_max = limit->value;
+        }
+
+        if (setrlimit(limit->resource->resource, &current) != 0)
+        {
+            fprintf(stderr, "%s: Error. -%c: %s\n", name, limit->resource->option, strerror(errno));
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Check if a command is a prefix applying to the command following it, like
+ * `limit -n 64 cmd`, `pin 0-3 cmd` or `batch rm *.o`, rather than an internal
+ * command.
+ *
+ * @param arguments The arguments of the command.
+ * @return 1 if the command is a prefix, 0 otherwise.
+ */
+static int prefixed(char **arguments)
+{
+    if (strcmp(arguments[COMMAND], "limit") == 0 || strcmp(arguments[COMMAND], "batch") == 0)
+    {
+        return 1;
+    }
+
+    // `pin` alone or followed by a job is the internal command
+    return strcmp(arguments[COMMAND], "pin") == 0 && arguments[1] != NULL && arguments[1][0] != JOB_PREFIX;
+}
+
+/**
+ * Remove the `limit`, `pin` and `batch` prefixes from the first command of a line,
+ * such as `limit -v 2G pin l3 make | tee log`, keeping their settings.
+ *
+ * @param command A pointer to the first command of an expanded line, whose
+ * arguments are shifted to start at the command following the prefixes.
+ * @param prefix A pointer to the structure where the settings are stored.
+ * @return `EXIT_SUCCESS` if the prefixes were valid, `EXIT_FAILURE`
+ * otherwise.
+ */
+static int stripPrefixes(tcommand *command, tprefix *prefix)
+{
+    const char *name;
+    int index;
+    int first;
+
+    prefix->limits.size = 0;
+    prefix->placement.mode = PIN_NONE;
+    prefix->batch.jobs = 0;
+
+    while (command->argv[COMMAND] != NULL && prefixed(command->argv))
+    {
+        if (strcmp(command->argv[COMMAND], "limit") == 0)
+        {
+            name = "limit";
+            first = parseLimits(command->argv, &prefix->limits, 1);
+        }
+        else if (strcmp(command->argv[COMMAND], "batch") == 0)
+        {
+            name = "batch";
+            first = parseBatch(command->argv, &prefix->batch);
+        }
+        else
+        {
+            name = "pin";
+            first = parsePlacement(command->argv, PLACEMENT, &prefix->placement);
+        }
+
+        if (first < 0)
+        {
+            return EXIT_FAILURE;
+        }
+
+        for (index = 0; index < first; index++)
+        {
+            free(command->argv[index]);
+        }
+
+        memmove(command->argv, command->argv + first, sizeof(char *) * (command->argc - first + 1));
+        command->argc -= first;
+    }
+
+    if (command->argv[COMMAND] == NULL)
+    {
+        fprintf(stderr, "%s: Error. Missing command\n", name);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Parse the options of a `batch` prefix: `-j` followed by the number of
+ * batches run at once, and `-f` followed by the number of arguments given to
+ * every batch, such as the pattern of `grep`.
+ *
+ * @param arguments The arguments of the prefix, starting with its name.
+ * @param batch A pointer to the structure where the options are stored.
+ * @return The index of the command, or -1 if the options are invalid.
+ */
+static int parseBatch(char **arguments, tbatch *batch)
+{
+    char *option;
+    char *end;
+    long value;
+    long minimum, maximum;
+    int index;
+
+    batch->jobs = 1;
+    batch->fixed = 0;
+
+    for (index = 1; arguments[index] != NULL && (strcmp(arguments[index], "-j") == 0 || strcmp(arguments[index], "-f") == 0); index += 2)
+    {
+        option = arguments[index];
+
+        if (arguments[index + 1] == NULL)
+        {
+            fprintf(stderr, "%s: Error. Missing number\n", option);
+            return -1;
+        }
+
+        value = strtol(arguments[index + 1], &end, 10);
+
+        minimum = option[1] == 'j' ? 1 : 0;
+        maximum = option[1] == 'j' ? MAXIMUM_BATCHES : INT_MAX;
+
+        if (*end != '\0' || end == arguments[index + 1] || value < minimum || value > maximum)
+        {
+            fprintf(stderr, "%s: Error. Invalid number\n", arguments[index + 1]);
+            return -1;
+        }
+
+        if (option[1] == 'j')
+        {
+            batch->jobs = value;
+        }
+        else
+        {
+            batch->fixed = value;
+        }
+    }
+
+    return index;
+}
+
+/**
+ * Execute a command split into batches that each fit in the argument space
+ * of `execve()`, like `xargs` does. Every batch gets the command, its fixed
+ * arguments and as many of the remaining ones as fit.
+ *
+ * Called by the child of the command, so the batches share its standard
+ * files, process group and limits.
+ *
+ * @param arguments The `NULL` terminated array of arguments of the command.
+ * @param environment The `NULL` terminated array of exported variables.
+ * @param batch A pointer to the options of the `batch` prefix.
+ * @return `EXIT_SUCCESS` if every batch succeeded, or the exit status of the
+ * first batch that failed, in the order of the arguments.
+ */
+static int runBatches(char **arguments, char **environment, const tbatch *batch)
+{
+    pid_t pids[MAXIMUM_BATCHES];
+    int numbers[MAXIMUM_BATCHES];
+    char **list;
+    long space, fixedSize, used, length;
+    int count, fixed, next, size;
+    int running, number, failed;
+    int status;
+    pid_t pid;
+
+    count = countArguments(arguments);
+    fixed = batch->fixed + 1 < count ? batch->fixed + 1 : count;
+    space = argumentSpace(environment);
+    fixedSize = argumentsSize(arguments, fixed);
+
+    if (fixedSize < 0 || fixedSize > space)
+    {
+        fprintf(stderr, "batch: Error. %s\n", strerror(E2BIG));
+        return CANNOT_EXECUTE;
+    }
+
+    list = malloc(sizeof(char *) * (count + 1));
+    memcpy(list, arguments, sizeof(char *) * fixed);
+
+    next = fixed;
+    running = 0;
+    failed = -1;
+    status = EXIT_SUCCESS;
+
+    for (number = 0; number == 0 || next < count; number++)
+    {
+        size = fixed;
+        used = fixedSize;
+
+        for (; next < count; next++)
+        {
+            length = argumentsSize(&arguments[next], 1);
+
+            if (length < 0 || used + length > space)
+            {
+                break;
+            }
+
+            list[size++] = arguments[next];
+            used += length;
+        }
+
+        // Not even a single argument fits next to the fixed ones
+        if (size == fixed && next < count)
+        {
+            fprintf(stderr, "batch: Error. %s: %s\n", arguments[COMMAND], strerror(E2BIG));
+
+            if (failed < 0)
+            {
+                failed = number;
+                status = CANNOT_EXECUTE;
+            }
+
+            break;
+        }
+
+        list[size] = NULL;
+
+        if (running == batch->jobs)
+        {
+            waitBatch(pids, numbers, &running, &failed, &status);
+        }
+
+        pid = fork();
+
+        if (pid == FORK_CHILD)
+        {
+            execute(list, environment);
+        }
+
+        if (pid < 0)
+        {
+            fprintf(stderr, "batch: Error. %s\n", strerror(errno));
+
+            if (failed < 0)
+            {
+                failed = number;
+                status = EXIT_FAILURE;
+            }
+
+            break;
+        }
+
+        pids[running] = pid;
+        numbers[running] = number;
+        running++;
+    }
+
+    while (running > 0)
+    {
+        waitBatch(pids, numbers, &running, &failed, &status);
+    }
+
+    free(list);
+
+    return status;
+}
+
+/**
+ * Wait for one of the batches running, keeping the status of the first
+ * batch that failed.
+ *
+ * @param pids The process identifiers of the batches running.
+ * @param numbers The numbers of the batches running, in the order of their
+ * arguments.
+ * @param running A pointer to the number of batches running, decreased by
+ * one.
+ * @param failed A pointer to the number of the first batch that failed, or
+ * -1.
+ * @param status A pointer to the exit status of the first batch that failed.
+ */
+static void waitBatch(pid_t *pids, int *numbers, int *running, int *failed, int *status)
+{
+    pid_t pid;
+    int result;
+    int index;
+
+    do
+    {
+        pid = waitpid(-1, &result, 0);
+    } while (pid < 0 && errno == EINTR);
+
+    for (index = 0; index < *running && pids[index] != pid; index++)
+    {
+    }
+
+    if (index == *running)
+    {
+        *running = 0;
+        return;
+    }
+
+    if (exitStatus(result) != EXIT_SUCCESS && (*failed < 0 || numbers[index] < *failed))
+    {
+        *failed = numbers[index];
+        *status = exitStatus(result);
+    }
+
+    (*running)--;
+    pids[index] = pids[*running];
+    numbers[index] = numbers[*running];
+}
+
+/**
+ * Find the `|||` operators of a pipeline, such as `|||4`, `|||8h` or
+ * `|||2k`, and replace them by the plain pipes the parser understands,
+ * keeping how many instances of the command following each one run and how
+ * the records are distributed among them.
+ *
+ * @param buffer The pipeline, modified in place.
+ * @param stages A pointer to the structure where the commands run in several
+ * instances are stored.
+ * @return `EXIT_SUCCESS` if every operator is valid, `EXIT_FAILURE`
+ * otherwise.
+ */
+static int splitStages(char *buffer, tstages *stages)
+{
+    char *cursor, *end;
+    long instances;
+    int command, index;
+
+    stages->size = 0;
+
+    for (index = 0; index < MAXIMUM_PID_LIST_SIZE; index++)
+    {
+        stages->instances[index] = 1;
+        stages->modes[index] = SPLIT_ROUND_ROBIN;
+    }
+
+    command = 0;
+
+    for (cursor = buffer; *cursor != '\0'; cursor++)
+    {
+        if (*cursor != '|')
+        {
+            continue;
+        }
+
+        command++;
+
+        if (strncmp(cursor, PARALLEL_OPERATOR, strlen(PARALLEL_OPERATOR)) != 0)
+        {
+            continue;
+        }
+
+        memset(cursor + 1, ' ', strlen(PARALLEL_OPERATOR) - 1);
+        cursor += strlen(PARALLEL_OPERATOR);
+
+        instances = strtol(cursor, &end, 10);
+
+        if (*cursor < '0' || *cursor > '9' || instances < 1 || instances > MAXIMUM_INSTANCES || command >= MAXIMUM_PID_LIST_SIZE)
+        {
+            fprintf(stderr, "%s: Error. Invalid number of instances\n", PARALLEL_OPERATOR);
+            return EXIT_FAILURE;
+        }
+
+        if (*end == HASH_SUFFIX || *end == ORDERED_SUFFIX)
+        {
+            stages->modes[command] = *end == HASH_SUFFIX ? SPLIT_HASH : SPLIT_ORDERED;
+            end++;
+        }
+
+        stages->instances[command] = instances;
+        stages->size++;
+
+        memset(cursor, ' ', end - cursor);
+        cursor = end - 1;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Run a command of a pipeline in several instances, distributing the records
+ * of its input among them and merging their outputs into its own.
+ *
+ * Called by the child of the command after its redirections and pipes, so
+ * the instances belong to the process group of the job, and the child is the
+ * process the shell waits for. A single `poll()` loop reads the input, feeds
+ * the instances through non-blocking pipes and reads their outputs, so an
+ * instance blocked on its output never stops the others from being fed. The
+ * records are lines, and the outputs are merged line by line, so the lines
+ * of different instances never mix. The records that could not be written
+ * to an instance because it exited are counted, and make the command fail.
+ *
+ * @param line A pointer to the command line.
+ * @param number The index of the command within the command line.
+ * @param environment The `NULL` terminated array of exported variables.
+ * @param builtins A pointer to the list of builtins loaded from shared
+ * objects.
+ * @param size The number of instances.
+ * @param mode How the records are distributed, such as `SPLIT_HASH`.
+ * @return `EXIT_SUCCESS` if every instance succeeded, or the exit status of
+ * the first one that failed.
+ */
+static int runInstances(const tline *line, const int number, char **environment, tbuiltins *builtins, const int size, const int mode)
+{
+    tinstance instances[MAXIMUM_INSTANCES];
+    struct pollfd descriptors[MAXIMUM_INSTANCES * 2 + 1];
+    tinstance *polled[MAXIMUM_INSTANCES * 2 + 1];
+    char block[RECORD_BLOCK];
+    tinstance *instance;
+    tarena carry;
+    ssize_t bytes;
+    int reading, count, index, length;
+    int next, sequence, emitted;
+    int failed, status, lost;
+
+    // An instance exiting early must not kill the merge of the others
+    signal(SIGPIPE, SIG_IGN);
+
+    memset(instances, 0, sizeof(instances));
+    memset(&carry, 0, sizeof(tarena));
+
+    for (index = 0; index < size; index++)
+    {
+        instances[index].input = NO_FILE;
+        instances[index].output = NO_FILE;
+        instances[index].sequence = -1;
+    }
+
+    reading = 1;
+    failed = -1;
+    status = EXIT_SUCCESS;
+
+    // Ordered instances are started for every chunk instead
+    for (index = 0; index < size && mode != SPLIT_ORDERED; index++)
+    {
+        if (startInstance(&instances[index], instances, size, line, number, environment, builtins) != EXIT_SUCCESS)
+        {
+            fprintf(stderr, "%s: Error. %s\n", PARALLEL_OPERATOR, strerror(errno));
+            failed = 0;
+            status = EXIT_FAILURE;
+            reading = 0;
+            break;
+        }
+    }
+
+    next = 0;
+    sequence = 0;
+    emitted = 0;
+
+    for (;;)
+    {
+        if (mode != SPLIT_ORDERED)
+        {
+            dispatchRecords(instances, size, mode, &carry, !reading, &next);
+        }
+
+        // A chunk for a new instance once it is big enough or the input ended
+        for (index = 0; mode == SPLIT_ORDERED && index < size && carry.size > 0 && (!reading || carry.size >= ORDERED_CHUNK); index++)
+        {
+            instance = &instances[index];
+            length = reading ? recordsLength(carry.data, carry.size) : carry.size;
+
+            if (instance->sequence >= 0 || length == 0)
+            {
+                continue;
+            }
+
+            if (startInstance(instance, instances, size, line, number, environment, builtins) != EXIT_SUCCESS)
+            {
+                fprintf(stderr, "%s: Error. %s\n", PARALLEL_OPERATOR, strerror(errno));
+                if (failed < 0 || sequence < failed)
+                {
+                    failed = sequence;
+                    status = EXIT_FAILURE;
+                }
+
+                reading = 0;
+                carry.size = 0;
+                break;
+            }
+
+            instance->sequence = sequence++;
+            append(&instance->pending, carry.data, length);
+            consume(&carry, length);
+        }
+
+        // Instances see the end of their input once every record reached them
+        for (index = 0; index < size; index++)
+        {
+            instance = &instances[index];
+
+            if (instance->input != NO_FILE && instance->written == instance->pending.size && (mode == SPLIT_ORDERED || (!reading && carry.size == 0)))
+            {
+                close(instance->input);
+                instance->input = NO_FILE;
+            }
+        }
+
+        count = 0;
+
+        if (reading && wantsRecords(instances, size, mode, &carry))
+        {
+            descriptors[count].fd = STDIN_FILENO;
+            descriptors[count].events = POLLIN;
+            polled[count++] = NULL;
+        }
+
+        for (index = 0; index < size; index++)
+        {
+            instance = &instances[index];
+
+            if (instance->input != NO_FILE && instance->written < instance->pending.size)
+            {
+                descriptors[count].fd = instance->input;
+                descriptors[count].events = POLLOUT;
+                polled[count++] = instance;
+            }
+
+            // An ordered instance ahead of the oldest one is left blocked
+            // on its output once enough of it is kept
+            if (instance->output != NO_FILE && (mode != SPLIT_ORDERED || instance->sequence == emitted || instance->received.size < ORDERED_BACKLOG))
+            {
+                descriptors[count].fd = instance->output;
+                descriptors[count].events = POLLIN;
+                polled[count++] = instance;
+            }
+        }
+
+        if (count == 0)
+        {
+            break;
+        }
+
+        if (poll(descriptors, count, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            break;
+        }
+
+        for (index = 0; index < count; index++)
+        {
+            if (descriptors[index].revents == 0)
+            {
+                continue;
+            }
+
+            if (polled[index] == NULL)
+            {
+                bytes = read(STDIN_FILENO, block, RECORD_BLOCK);
+
+                if (bytes > 0)
+                {
+                    append(&carry, block, bytes);
+                }
+                else if (bytes == 0 || errno != EINTR)
+                {
+                    reading = 0;
+                }
+            }
+            else if (descriptors[index].events == POLLOUT)
+            {
+                writeRecords(polled[index], mode);
+            }
+            else
+            {
+                readOutput(polled[index], mode, emitted);
+            }
+        }
+
+        // The oldest chunk streams its output, and the next ones follow
+        // once it ended
+        for (index = 0; mode == SPLIT_ORDERED && index < size; index++)
+        {
+            instance = &instances[index];
+
+            if (instance->sequence != emitted)
+            {
+                continue;
+            }
+
+            emit(instance->received.data, instance->received.size);
+            instance->received.size = 0;
+
+            if (instance->output != NO_FILE)
+            {
+                break;
+            }
+
+            waitInstance(instance, instance->sequence, &failed, &status);
+            instance->sequence = -1;
+            emitted++;
+            index = -1;
+        }
+    }
+
+    lost = 0;
+
+    for (index = 0; index < size; index++)
+    {
+        instance = &instances[index];
+
+        if (instance->pid > 0)
+        {
+            waitInstance(instance, mode == SPLIT_ORDERED ? instance->sequence : index, &failed, &status);
+        }
+
+        lost += instance->lost;
+
+        free(instance->pending.data);
+        free(instance->received.data);
+    }
+
+    free(carry.data);
+
+    if (lost > 0)
+    {
+        fprintf(stderr, "%s: Error. %i records lost by instances that exited\n", PARALLEL_OPERATOR, lost);
+        status = status != EXIT_SUCCESS ? status : EXIT_FAILURE;
+    }
+
+    return status;
+}
+
+/**
+ * Start an instance of a command run with `|||`, connected to the process
+ * running it through a pipe for its input and another one for its output.
+ *
+ * @param instance A pointer to the structure representing the instance.
+ * @param instances The instances already started, whose pipes the new one
+ * closes.
+ * @param size The number of instances.
+ * @param line A pointer to the command line.
+ * @param number The index of the command within the command line.
+ * @param environment The `NULL` terminated array of exported variables.
+ * @param builtins A pointer to the list of builtins loaded from shared
+ * objects.
+ * @return `EXIT_SUCCESS` if the instance was started, `EXIT_FAILURE`
+ * otherwise, with `errno` set.
+ */
+static int startInstance(tinstance *instance, tinstance *instances, const int size, const tline *line, const int number, char **environment, tbuiltins *builtins)
+{
+    int input[PIPE], output[PIPE];
+    int index;
+
+    if (pipe(input) != 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (pipe(output) != 0)
+    {
+        close(input[PIPE_READ]);
+        close(input[PIPE_WRITE]);
+        return EXIT_FAILURE;
+    }
+
+    instance->pid = fork();
+
+    if (instance->pid == FORK_CHILD)
+    {
+        signal(SIGPIPE, SIG_DFL);
+
+        // The input of another instance would never end while it is open
+        for (index = 0; index < size; index++)
+        {
+            if (instances[index].input != NO_FILE)
+            {
+                close(instances[index].input);
+            }
+
+            if (instances[index].output != NO_FILE)
+            {
+                close(instances[index].output);
+            }
+        }
+
+        dup2(input[PIPE_READ], STDIN_FILENO);
+        dup2(output[PIPE_WRITE], STDOUT_FILENO);
+        close(input[PIPE_READ]);
+        close(input[PIPE_WRITE]);
+        close(output[PIPE_READ]);
+        close(output[PIPE_WRITE]);
+
+        run(line, number, environment, builtins);
+    }
+
+    close(input[PIPE_READ]);
+    close(output[PIPE_WRITE]);
+
+    if (instance->pid < 0)
+    {
+        close(input[PIPE_WRITE]);
+        close(output[PIPE_READ]);
+        instance->pid = 0;
+        return EXIT_FAILURE;
+    }
+
+    fcntl(input[PIPE_WRITE], F_SETFL, O_NONBLOCK);
+
+    instance->input = input[PIPE_WRITE];
+    instance->output = output[PIPE_READ];
+    instance->pending.size = 0;
+    instance->written = 0;
+    instance->received.size = 0;
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Hand the complete records read so far to the instances that run for the
+ * whole input: each record to the instance chosen by the hash of its first
+ * field, or all of them to the next idle instance in turn.
+ *
+ * @param instances The instances.
+ * @param size The number of instances.
+ * @param mode How the records are distributed, `SPLIT_ROUND_ROBIN` or
+ * `SPLIT_HASH`.
+ * @param carry A pointer to the input read and not distributed yet, whose
+ * distributed records are removed.
+ * @param ending Flag indicating whether the input ended, so its last record
+ * is complete even without a newline.
+ * @param next A pointer to the instance tried first in turn.
+ */
+static void dispatchRecords(tinstance *instances, const int size, const int mode, tarena *carry, const int ending, int *next)
+{
+    tinstance *instance;
+    char *newline;
+    int start, end, length, index;
+
+    if (mode == SPLIT_HASH)
+    {
+        for (start = 0; start < carry->size; start = end)
+        {
+            newline = memchr(carry->data + start, '\n', carry->size - start);
+
+            if (newline == NULL && !ending)
+            {
+                break;
+            }
+
+            end = newline != NULL ? newline - carry->data + 1 : carry->size;
+            instance = &instances[recordHash(carry->data + start, end - start) % size];
+
+            if (instance->input != NO_FILE)
+            {
+                append(&instance->pending, carry->data + start, end - start);
+            }
+            else
+            {
+                instance->lost++;
+            }
+        }
+
+        consume(carry, start);
+        return;
+    }
+
+    length = ending ? carry->size : recordsLength(carry->data, carry->size);
+
+    for (index = 0; index < size && length > 0; index++)
+    {
+        instance = &instances[(*next + index) % size];
+
+        if (instance->input != NO_FILE && instance->pending.size == 0)
+        {
+            append(&instance->pending, carry->data, length);
+            consume(carry, length);
+            *next = (*next + index + 1) % size;
+            return;
+        }
+    }
+}
+
+/**
+ * Check if more of the input of a command run with `|||` can be read, which
+ * stops while its instances are busy so the records never pile up in memory.
+ *
+ * @param instances The instances.
+ * @param size The number of instances.
+ * @param mode How the records are distributed.
+ * @param carry A pointer to the input read and not distributed yet.
+ * @return 1 if the input can be read, 0 otherwise.
+ */
+static int wantsRecords(const tinstance *instances, const int size, const int mode, const tarena *carry)
+{
+    int index, open;
+
+    if (mode == SPLIT_ORDERED)
+    {
+        return carry->size < ORDERED_CHUNK || recordsLength(carry->data, carry->size) == 0;
+    }
+
+    open = 0;
+
+    for (index = 0; index < size; index++)
+    {
+        if (instances[index].input == NO_FILE)
+        {
+            continue;
+        }
+
+        // A round robin needs an idle instance, a hash every one of them
+        if (mode == SPLIT_ROUND_ROBIN && instances[index].pending.size == 0)
+        {
+            return 1;
+        }
+
+        if (mode == SPLIT_HASH && instances[index].pending.size - instances[index].written >= RECORD_BLOCK)
+        {
+            return 0;
+        }
+
+        open++;
+    }
+
+    return mode == SPLIT_HASH && open > 0;
+}
+
+/**
+ * Write the pending records of an instance to its input, as many as its
+ * pipe accepts without blocking.
+ *
+ * @param instance A pointer to the structure representing the instance.
+ * @param mode How the records are distributed.
+ */
+static void writeRecords(tinstance *instance, const int mode)
+{
+    ssize_t bytes;
+    int length;
+
+    length = instance->pending.size - instance->written;
+    length = length < RECORD_BLOCK ? length : RECORD_BLOCK;
+
+    bytes = write(instance->input, instance->pending.data + instance->written, length);
+
+    if (bytes < 0 && errno != EAGAIN && errno != EINTR)
+    {
+        // The instance exited without reading its whole input
+        instance->lost += recordsCount(instance->pending.data + instance->written, instance->pending.size - instance->written);
+        close(instance->input);
+        instance->input = NO_FILE;
+        instance->pending.size = 0;
+        instance->written = 0;
+        return;
+    }
+
+    instance->written += bytes > 0 ? bytes : 0;
+
+    if (instance->written == instance->pending.size && mode != SPLIT_ORDERED)
+    {
+        instance->pending.size = 0;
+        instance->written = 0;
+    }
+}
+
+/**
+ * Read the output of an instance, writing its complete lines to the output
+ * of the command, or all of it if it is the oldest chunk of an ordered
+ * command, and keeping the rest.
+ *
+ * @param instance A pointer to the structure representing the instance.
+ * @param mode How the records are distributed.
+ * @param emitted The number of the chunk whose output is being written.
+ */
+static void readOutput(tinstance *instance, const int mode, const int emitted)
+{
+    char block[RECORD_BLOCK];
+    ssize_t bytes;
+    int length;
+
+    bytes = read(instance->output, block, RECORD_BLOCK);
+
+    if (bytes < 0 && (errno == EINTR || errno == EAGAIN))
+    {
+        return;
+    }
+
+    if (bytes <= 0)
+    {
+        close(instance->output);
+        instance->output = NO_FILE;
+
+        if (mode != SPLIT_ORDERED)
+        {
+            emit(instance->received.data, instance->received.size);
+            instance->received.size = 0;
+        }
+
+        return;
+    }
+
+    if (mode == SPLIT_ORDERED && instance->sequence == emitted)
+    {
+        emit(block, bytes);
+        return;
+    }
+
+    append(&instance->received, block, bytes);
+
+    if (mode != SPLIT_ORDERED)
+    {
+        length = recordsLength(instance->received.data, instance->received.size);
+        emit(instance->received.data, length);
+        consume(&instance->received, length);
+    }
+}
+
+/**
+ * Wait for an instance to finish, keeping the status of the first instance
+ * that failed.
+ *
+ * @param instance A pointer to the structure representing the instance.
+ * @param rank The position of the instance, or of its chunk if it keeps the
+ * order.
+ * @param failed A pointer to the rank of the first instance that failed, or
+ * -1.
+ * @param status A pointer to the exit status of the first instance that
+ * failed.
+ */
+static void waitInstance(tinstance *instance, const int rank, int *failed, int *status)
+{
+    int result;
+
+    if (instance->input != NO_FILE)
+    {
+        close(instance->input);
+        instance->input = NO_FILE;
+    }
+
+    while (waitpid(instance->pid, &result, 0) < 0)
+    {
+        if (errno != EINTR)
+        {
+            instance->pid = 0;
+            return;
+        }
+    }
+
+    instance->pid = 0;
+
+    if (exitStatus(result) != EXIT_SUCCESS && (*failed < 0 || rank < *failed))
+    {
+        *failed = rank;
+        *status = exitStatus(result);
+    }
+}
+
+/**
+ * Get the length of the complete records at the start of some data.
+ *
+ * @param data The data.
+ * @param size The number of bytes of the data.
+ * @return The number of bytes up to the last newline included, or 0 if there
+ * is none.
+ */
+static int recordsLength(const char *data, const int size)
+{
+    const char *newline;
+
+    newline = size > 0 ? memrchr(data, '\n', size) : NULL;
+
+    return newline != NULL ? newline - data + 1 : 0;
+}
+
+/**
+ * Count the records of some data, including a last one without a newline.
+ *
+ * @param data The data.
+ * @param size The number of bytes of the data.
+ * @return The number of records.
+ */
+static int recordsCount(const char *data, const int size)
+{
+    const char *newline;
+    int count, start;
+
+    count = 0;
+
+    for (start = 0; start < size; start = newline != NULL ? newline - data + 1 : size)
+    {
+        newline = memchr(data + start, '\n', size - start);
+        count++;
+    }
+
+    return count;
+}
+
+/**
+ * Remove bytes from the start of an arena.
+ *
+ * @param arena A pointer to the arena.
+ * @param size The number of bytes removed.
+ */
+static void consume(tarena *arena, const int size)
+{
+    if (size <= 0)
+    {
+        return;
+    }
+
+    memmove(arena->data, arena->data + size, arena->size - size);
+    arena->size -= size;
+}
+
+/**
+ * Hash the key of a record, which is its first field, so the records
+ * sharing a key always reach the same instance.
+ *
+ * @param record The record.
+ * @param length The number of bytes of the record.
+ * @return The FNV-1a hash of the key.
+ */
+static unsigned int recordHash(const char *record, const int length)
+{
+    unsigned int hash;
+    int index;
+
+    hash = FNV_OFFSET;
+
+    for (index = 0; index < length && record[index] != ' ' && record[index] != '\t' && record[index] != '\n'; index++)
+    {
+        hash = (hash ^ (unsigned char)record[index]) * FNV_PRIME;
+    }
+
+    return hash;
+}
+
+/**
+ * Write the output of the instances of a command to its own output. If
+ * nobody reads it anymore, the process is terminated by `SIGPIPE` like any
+ * other command writing to a closed pipe.
+ *
+ * @param data The bytes to be written.
+ * @param size The number of bytes.
+ */
+static void emit(const char *data, int size)
+{
+    ssize_t bytes;
+
+    while (size > 0)
+    {
+        bytes = write(STDOUT_FILENO, data, size);
+
+        if (bytes < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (bytes < 0)
+        {
+            signal(SIGPIPE, SIG_DFL);
+            raise(SIGPIPE);
+            _exit(SIGNAL_STATUS + SIGPIPE);
+        }
+
+        data += bytes;
+        size -= bytes;
+    }
+}
+
+/**
+ * Take the branches of a fan-out such as `a |{ b ; c | d } | e` out of a
+ * pipeline, replacing them by a single command that stands for them.
+ *
+ * @param buffer The pipeline, modified in place.
+ * @param graph A pointer to the structure where the branches are stored.
+ * @return `EXIT_SUCCESS` if the line has at most one valid fan-out,
+ * `EXIT_FAILURE` otherwise.
+ */
+static int splitGraph(char *buffer, tgraph *graph)
+{
+    char *start, *cursor;
+    int length;
+
+    graph->text = NULL;
+    graph->size = 0;
+    graph->stage = 0;
+
+    start = strstr(buffer, FAN_OUT);
+
+    if (start == NULL)
+    {
+        return EXIT_SUCCESS;
+    }
+
+    length = closing(start + 1, '{', '}');
+
+    if (length < 0)
+    {
+        fprintf(stderr, "%s: Error. Missing }\n", FAN_OUT);
+        return EXIT_FAILURE;
+    }
+
+    // Pipes up to the fan-out, counting `|||` as a single one
+    for (cursor = buffer; cursor <= start; cursor++)
+    {
+        if (*cursor == '|')
+        {
+            graph->stage++;
+            cursor += strncmp(cursor, PARALLEL_OPERATOR, strlen(PARALLEL_OPERATOR)) == 0 ? strlen(PARALLEL_OPERATOR) - 1 : 0;
+        }
+    }
+
+    graph->text = strndup(start + 2, length - 1);
+
+    if (strstr(graph->text, FAN_OUT) != NULL || strstr(start + length + 1, FAN_OUT) != NULL)
+    {
+        fprintf(stderr, "%s: Error. A single fan-out per line is supported\n", FAN_OUT);
+        return EXIT_FAILURE;
+    }
+
+    for (cursor = graph->text; cursor != NULL; cursor = strchr(cursor, BRANCH_SEPARATOR))
+    {
+        if (*cursor == BRANCH_SEPARATOR)
+        {
+            *cursor++ = '\0';
+        }
+
+        if (graph->size == MAXIMUM_BRANCHES || strspn(cursor, " \t") == strcspn(cursor, ";"))
+        {
+            fprintf(stderr, "%s: Error. %s\n", FAN_OUT, graph->size == MAXIMUM_BRANCHES ? "Too many branches" : "Empty branch");
+            return EXIT_FAILURE;
+        }
+
+        graph->branches[graph->size++] = cursor;
+    }
+
+    memset(start + 1, ' ', length + 1);
+    memcpy(start + 1, BRANCHES_STAGE, strlen(BRANCHES_STAGE));
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Run the branches of a fan-out, sending each of them the whole input of
+ * the command standing for them and merging their outputs into its output.
+ *
+ * Called by the child of that command, which starts the commands of every
+ * branch and a merger, and then copies its input to the branches. The input
+ * is duplicated with `tee()` and moved to the last branch with `splice()`,
+ * so the data is only copied by the kernel between pipes while the branches
+ * keep up. The merger writes the complete lines of the branches as they
+ * come, in a process of its own so a branch blocked on its output never
+ * stops the input of the others.
+ *
+ * @param graph A pointer to the branches of the fan-out.
+ * @param shell A pointer to the structure representing the shell state.
+ * @param environment The `NULL` terminated array of exported variables.
+ * @return `EXIT_SUCCESS` if every branch succeeded, or the exit status of
+ * the first one that failed, in the order of the line.
+ */
+static int runGraph(const tgraph *graph, tshell *shell, char **environment)
+{
+    tline *branches[MAXIMUM_BRANCHES];
+    tinstance outputs[MAXIMUM_BRANCHES];
+    int inputs[MAXIMUM_BRANCHES];
+    pid_t lasts[MAXIMUM_BRANCHES];
+    tline *line;
+    pid_t merger, pid;
+    int index, result, status, merged;
+
+    // A branch exiting early must not stop the others
+    signal(SIGPIPE, SIG_IGN);
+
+    for (index = 0; index < graph->size; index++)
+    {
+        line = tokenize(graph->branches[index]);
+
+        if (line == NULL || line->ncommands < 1 || line->background)
+        {
+            fprintf(stderr, "%s: Error. Invalid branch\n", FAN_OUT);
+            return EXIT_FAILURE;
+        }
+
+        branches[index] = expand(line, &shell->variables);
+    }
+
+    memset(outputs, 0, sizeof(outputs));
+
+    for (index = 0; index < graph->size; index++)
+    {
+        outputs[index].input = NO_FILE;
+
+        if (startBranch(branches[index], environment, &shell->builtins, &inputs[index], &outputs[index].output, &lasts[index]) != EXIT_SUCCESS)
+        {
+            fprintf(stderr, "%s: Error. %s\n", FAN_OUT, strerror(errno));
+            lasts[index] = -EXIT_FAILURE;
+        }
+    }
+
+    merger = fork();
+
+    if (merger == FORK_CHILD)
+    {
+        signal(SIGPIPE, SIG_DFL);
+
+        // The branches would never see the end of their input
+        for (index = 0; index < graph->size; index++)
+        {
+            if (inputs[index] != NO_FILE)
+            {
+                close(inputs[index]);
+            }
+        }
+
+        close(STDIN_FILENO);
+        mergeOutputs(outputs, graph->size);
+        leave(EXIT_SUCCESS);
+    }
+
+    for (index = 0; index < graph->size; index++)
+    {
+        if (outputs[index].output != NO_FILE)
+        {
+            close(outputs[index].output);
+        }
+    }
+
+    // Without a merger the outputs of the branches would fill up
+    if (merger > 0)
+    {
+        fanOut(inputs, graph->size);
+    }
+
+    for (index = 0; index < graph->size; index++)
+    {
+        if (inputs[index] != NO_FILE)
+        {
+            close(inputs[index]);
+        }
+    }
+
+    status = EXIT_SUCCESS;
+    merged = merger > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    for (;;)
+    {
+        pid = waitpid(-1, &result, 0);
+
+        if (pid < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            break;
+        }
+
+        if (pid == merger)
+        {
+            merged = exitStatus(result);
+        }
+
+        for (index = 0; index < graph->size; index++)
+        {
+            if (pid == lasts[index])
+            {
+                lasts[index] = exitStatus(result) == EXIT_SUCCESS ? 0 : -exitStatus(result);
+            }
+        }
+    }
+
+    for (index = 0; index < graph->size && status == EXIT_SUCCESS; index++)
+    {
+        status = lasts[index] < 0 ? -lasts[index] : EXIT_SUCCESS;
+    }
+
+    for (index = 0; index < graph->size; index++)
+    {
+        release(branches[index]);
+    }
+
+    return status != EXIT_SUCCESS ? status : merged;
+}
+
+/**
+ * Start the commands of a branch of a fan-out, connected to each other
+ * through pipes like in any pipeline.
+ *
+ * Every pipe is closed on `exec()`, so the commands of a branch never keep
+ * the pipes of the others open.
+ *
+ * @param line A pointer to the pipeline of the branch.
+ * @param environment The `NULL` terminated array of exported variables.
+ * @param builtins A pointer to the list of builtins loaded from shared
+ * objects.
+ * @param input A pointer where the pipe the branch reads from is stored, or
+ * `NO_FILE` if its input is redirected.
+ * @param output A pointer where the pipe the output of the branch is read
+ * from is stored.
+ * @param last A pointer where the process identifier of the last command of
+ * the branch is stored.
+ * @return `EXIT_SUCCESS` if every command was started, `EXIT_FAILURE`
+ * otherwise, with `errno` set.
+ */
+static int startBranch(const tline *line, char **environment, tbuiltins *builtins, int *input, int *output, pid_t *last)
+{
+    int first[PIPE], final[PIPE], p[PIPE];
+    int previous, command, next;
+    pid_t pid;
+
+    *input = NO_FILE;
+    *output = NO_FILE;
+    first[PIPE_READ] = NO_FILE;
+
+    if (line->redirect_input == NULL)
+    {
+        if (pipe2(first, O_CLOEXEC) != 0)
+        {
+            return EXIT_FAILURE;
+        }
+
+        *input = first[PIPE_WRITE];
+    }
+
+    if (pipe2(final, O_CLOEXEC) != 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    *output = final[PIPE_READ];
+    previous = first[PIPE_READ];
+
+    for (command = 0; command < line->ncommands; command++)
+    {
+        p[PIPE_READ] = NO_FILE;
+        next = final[PIPE_WRITE];
+
+        if (command < line->ncommands - 1)
+        {
+            if (pipe2(p, O_CLOEXEC) != 0)
+            {
+                break;
+            }
+
+            next = p[PIPE_WRITE];
+        }
+
+        pid = fork();
+
+        if (pid == FORK_CHILD)
+        {
+            signal(SIGPIPE, SIG_DFL);
+
+            if (previous != NO_FILE)
+            {
+                dup2(previous, STDIN_FILENO);
+            }
+
+            dup2(next, STDOUT_FILENO);
+
+            if (redirect(line, command == 0, command == line->ncommands - 1) != EXIT_SUCCESS)
+            {
+                leave(EXIT_FAILURE);
+            }
+
+            run(line, command, environment, builtins);
+        }
+
+        if (previous != NO_FILE)
+        {
+            close(previous);
+        }
+
+        if (p[PIPE_READ] != NO_FILE)
+        {
+            close(p[PIPE_WRITE]);
+        }
+
+        previous = p[PIPE_READ];
+
+        if (pid < 0)
+        {
+            break;
+        }
+
+        *last = pid;
+    }
+
+    if (previous != NO_FILE)
+    {
+        close(previous);
+    }
+
+    close(final[PIPE_WRITE]);
+
+    return command == line->ncommands ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * Copy the standard input to the branches of a fan-out until it ends or
+ * every branch stopped reading.
+ *
+ * Each block available in the input pipe is duplicated to every branch but
+ * the last one with `tee()`, which does not consume it, and then moved to
+ * the last one with `splice()`. A branch whose pipe cannot take the whole
+ * block at once gets the rest from a copy read into memory, since `tee()`
+ * always starts at the beginning of the input. The copy holds at least every
+ * byte some branch already got, so none of them is sent twice.
+ *
+ * The rest is written with blocking writes before the next block is read,
+ * so a branch that stops reading without exiting stalls the others, like a
+ * full pipe stalls the command writing to it.
+ *
+ * @param inputs The pipes the branches read from, `NO_FILE` for the ones
+ * that stopped reading, which are closed.
+ * @param size The number of branches.
+ */
+static void fanOut(int *inputs, const int size)
+{
+    char block[RECORD_BLOCK];
+    int copied[MAXIMUM_BRANCHES];
+    struct pollfd descriptor;
+    ssize_t bytes, moved;
+    int available, index, last, whole, length;
+    int needed, received;
+
+    descriptor.fd = STDIN_FILENO;
+    descriptor.events = POLLIN;
+
+    for (;;)
+    {
+        for (last = size - 1; last >= 0 && inputs[last] == NO_FILE; last--)
+        {
+        }
+
+        if (last < 0)
+        {
+            return;
+        }
+
+        if (poll(&descriptor, 1, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            return;
+        }
+
+        // Not a pipe, or the end of the input
+        if (ioctl(STDIN_FILENO, FIONREAD, &available) != 0 || available == 0)
+        {
+            available = RECORD_BLOCK;
+        }
+
+        length = available < RECORD_BLOCK ? available : RECORD_BLOCK;
+        whole = 1;
+
+        for (index = 0; index < last; index++)
+        {
+            copied[index] = length;
+
+            if (inputs[index] == NO_FILE)
+            {
+                continue;
+            }
+
+            bytes = tee(STDIN_FILENO, inputs[index], length, SPLICE_F_NONBLOCK);
+            copied[index] = bytes > 0 ? bytes : 0;
+            whole = whole && copied[index] == length;
+        }
+
+        moved = whole ? splice(STDIN_FILENO, NULL, inputs[last], NULL, length, 0) : -1;
+        copied[last] = moved > 0 ? moved : 0;
+
+        // The end of the input, which `splice()` also reports without data
+        if (moved == 0)
+        {
+            return;
+        }
+
+        if (moved == length)
+        {
+            continue;
+        }
+
+        needed = 0;
+
+        for (index = 0; index < last; index++)
+        {
+            if (inputs[index] != NO_FILE && copied[index] - copied[last] > needed)
+            {
+                needed = copied[index] - copied[last];
+            }
+        }
+
+        // The bytes duplicated by `tee()` are still in the pipe, so a short
+        // read is retried until it holds them all
+        received = 0;
+
+        do
+        {
+            bytes = read(STDIN_FILENO, block + received, length - copied[last] - received);
+            received += bytes > 0 ? bytes : 0;
+        } while ((bytes > 0 && received < needed) || (bytes < 0 && errno == EINTR));
+
+        if (received == 0)
+        {
+            return;
+        }
+
+        // Bytes already sent before the copy was read
+        length = copied[last] + received;
+
+        for (index = 0; index <= last; index++)
+        {
+            if (inputs[index] == NO_FILE || copied[index] >= length)
+            {
+                continue;
+            }
+
+            if (!deliver(inputs[index], block + copied[index] - copied[last], length - copied[index]))
+            {
+                close(inputs[index]);
+                inputs[index] = NO_FILE;
+            }
+        }
+    }
+}
+
+/**
+ * Write bytes to a file, waiting for it to take all of them.
+ *
+ * @param file The file descriptor.
+ * @param data The bytes to be written.
+ * @param size The number of bytes.
+ * @return 1 if every byte was written, 0 otherwise.
+ */
+static int deliver(int file, const char *data, int size)
+{
+    ssize_t bytes;
+
+    while (size > 0)
+    {
+        bytes = write(file, data, size);
+
+        if (bytes < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (bytes <= 0)
+        {
+            return 0;
+        }
+
+        data += bytes;
+        size -= bytes;
+    }
+
+    return 1;
+}
+
+/**
+ * Write the complete lines of the outputs of the branches of a fan-out to
+ * the standard output as they come, until every output ended.
+ *
+ * @param outputs The branches, whose `output` field holds the pipe their
+ * output is read from.
+ * @param size The number of branches.
+ */
+static void mergeOutputs(tinstance *outputs, const int size)
+{
+    struct pollfd descriptors[MAXIMUM_BRANCHES];
+    tinstance *polled[MAXIMUM_BRANCHES];
+    int count, index;
+
+    for (;;)
+    {
+        count = 0;
+
+        for (index = 0; index < size; index++)
+        {
+            if (outputs[index].output != NO_FILE)
+            {
+                descriptors[count].fd = outputs[index].output;
+                descriptors[count].events = POLLIN;
+                polled[count++] = &outputs[index];
+            }
+        }
+
+        if (count == 0)
+        {
+            return;
+        }
+
+        if (poll(descriptors, count, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            return;
+        }
+
+        for (index = 0; index < count; index++)
+        {
+            if (descriptors[index].revents != 0)
+            {
+                readOutput(polled[index], SPLIT_ROUND_ROBIN, 0);
+            }
+        }
+    }
+}
+
+/**
+ * Run a command once per item, keeping a number of them running at once,
+ * such as `parallel -j 4 gzip {} ::: *.log`. Every `{}` in the command is
+ * replaced by the item, which is otherwise added as its last argument. The
+ * items follow `:::`, or are the lines of the standard input.
+ *
+ * Called by the child of the command, so the commands share its process
+ * group and job. A single queue feeds the slots: as soon as a command is
+ * reaped through its process file descriptor, its slot takes the next item,
+ * so slow items never hold back the others. The output and error of each
+ * command are kept until it finishes and then written at once, so the
+ * outputs of different items never interleave. With `-v`, the number, exit
+ * status, duration and value of every item are written to the standard
+ * error after its output.
+ *
+ * `SIGINT` is received through a `signalfd` polled along with the commands.
+ * Once it arrives no more items are started, and `parallel` only waits for
+ * the commands already running, which got the signal from the terminal too.
+ *
+ * @param arguments The `NULL` terminated array of arguments, starting with
+ * `parallel`.
+ * @param environment The `NULL` terminated array of exported variables.
+ * @return `EXIT_SUCCESS` if every command succeeded, `SIGNAL_STATUS` plus
+ * `SIGINT` if it was interrupted, or the exit status of the first one that
+ * failed, in the order of the items.
+ */
+static int mshparallel(char **arguments, char **environment)
+{
+    struct signalfd_siginfo information;
+    sigset_t interrupts;
+    tarena input;
+    ttask *tasks;
+    struct pollfd *descriptors;
+    char **command, **items;
+    ssize_t bytes;
+    int jobs, verbose, first, end;
+    int count, next, running, slot, index;
+    int failed, status, interrupted;
+
+    first = parseParallel(arguments, &jobs, &verbose);
+
+    if (first < 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    for (end = first; arguments[end] != NULL && strcmp(arguments[end], ITEMS_SEPARATOR) != 0; end++)
+    {
+    }
+
+    if (end == first)
+    {
+        fprintf(stderr, "%s: Error. Missing command\n", PARALLEL);
+        return EXIT_FAILURE;
+    }
+
+    input.data = NULL;
+    input.size = 0;
+    input.capacity = 0;
+
+    if (arguments[end] != NULL)
+    {
+        items = &arguments[end + 1];
+        count = countArguments(items);
+        arguments[end] = NULL;
+    }
+    else
+    {
+        items = readItems(&input, &count);
+    }
+
+    command = &arguments[first];
+    tasks = calloc(jobs, sizeof(ttask));
+    descriptors = malloc(sizeof(struct pollfd) * (jobs * STANDARD_FILES + 1));
+
+    for (index = 0; index <= jobs * STANDARD_FILES; index++)
+    {
+        descriptors[index].fd = NO_FILE;
+        descriptors[index].events = POLLIN;
+    }
+
+    // The last descriptor tells when the driver is interrupted
+    sigemptyset(&interrupts);
+    sigaddset(&interrupts, SIGINT);
+    sigprocmask(SIG_BLOCK, &interrupts, NULL);
+    descriptors[jobs * STANDARD_FILES].fd = signalfd(NO_FILE, &interrupts, SFD_CLOEXEC);
+
+    if (descriptors[jobs * STANDARD_FILES].fd < 0)
+    {
+        sigprocmask(SIG_UNBLOCK, &interrupts, NULL);
+    }
+
+    next = 0;
+    running = 0;
+    failed = -1;
+    status = EXIT_SUCCESS;
+    interrupted = 0;
+
+    while ((next < count && !interrupted) || running > 0)
+    {
+        // A slot takes the next item as soon as its command is reaped
+        for (slot = 0; slot < jobs && next < count && !interrupted; slot++)
+        {
+            if (tasks[slot].pid == 0)
+            {
+                tasks[slot].item = next++;
+                startTask(&tasks[slot], &descriptors[slot * STANDARD_FILES], command, items[tasks[slot].item], environment);
+
+                if (tasks[slot].pid > 0)
+                {
+                    running++;
+                    continue;
+                }
+
+                finishTask(&tasks[slot], &descriptors[slot * STANDARD_FILES], items, verbose, &failed, &status);
+            }
+        }
+
+        if (running == 0)
+        {
+            continue;
+        }
+
+        if (poll(descriptors, jobs * STANDARD_FILES + 1, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            break;
+        }
+
+        if (descriptors[jobs * STANDARD_FILES].revents != 0 && read(descriptors[jobs * STANDARD_FILES].fd, &information, sizeof(information)) > 0)
+        {
+            interrupted = 1;
+        }
+
+        for (slot = 0; slot < jobs; slot++)
+        {
+            if (tasks[slot].pid <= 0)
+            {
+                continue;
+            }
+
+            for (index = 0; index < STANDARD_FILES; index++)
+            {
+                if (descriptors[slot * STANDARD_FILES + index].fd == NO_FILE || descriptors[slot * STANDARD_FILES + index].revents == 0)
+                {
+                    continue;
+                }
+
+                if (index == TASK_PROCESS)
+                {
+                    if (waitpid(tasks[slot].pid, &tasks[slot].status, WNOHANG) > 0)
+                    {
+                        tasks[slot].status = exitStatus(tasks[slot].status);
+                        close(descriptors[slot * STANDARD_FILES].fd);
+                        descriptors[slot * STANDARD_FILES].fd = NO_FILE;
+                    }
+                }
+                else
+                {
+                    reserve(&tasks[slot].captured[index], RECORD_BLOCK);
+                    bytes = read(descriptors[slot * STANDARD_FILES + index].fd, tasks[slot].captured[index].data + tasks[slot].captured[index].size, RECORD_BLOCK);
+
+                    if (bytes > 0)
+                    {
+                        tasks[slot].captured[index].size += bytes;
+                    }
+                    else if (bytes == 0 || errno != EINTR)
+                    {
+                        close(descriptors[slot * STANDARD_FILES + index].fd);
+                        descriptors[slot * STANDARD_FILES + index].fd = NO_FILE;
+                    }
+                }
+            }
+
+            if (descriptors[slot * STANDARD_FILES + STDOUT_FILENO].fd == NO_FILE && descriptors[slot * STANDARD_FILES + STDERR_FILENO].fd == NO_FILE && descriptors[slot * STANDARD_FILES].fd == NO_FILE)
+            {
+                finishTask(&tasks[slot], &descriptors[slot * STANDARD_FILES], items, verbose, &failed, &status);
+                running--;
+            }
+        }
+    }
+
+    for (slot = 0; slot < jobs; slot++)
+    {
+        for (index = 0; index < STANDARD_FILES; index++)
+        {
+            free(tasks[slot].captured[index].data);
+        }
+    }
+
+    if (descriptors[jobs * STANDARD_FILES].fd >= 0)
+    {
+        close(descriptors[jobs * STANDARD_FILES].fd);
+    }
+
+    free(tasks);
+    free(descriptors);
+    free(input.data);
+
+    if (input.capacity > 0)
+    {
+        free(items);
+    }
+
+    return interrupted ? SIGNAL_STATUS + SIGINT : status;
+}
+
+/**
+ * Parse the options of `parallel`: `-j` followed by the number of commands
+ * run at once, which defaults to the number of online processors, and `-v`
+ * to report every item.
+ *
+ * @param arguments The arguments of the command, starting with its name.
+ * @param jobs A pointer where the number of commands run at once is stored.
+ * @param verbose A pointer to the flag indicating whether every item is
+ * reported.
+ * @return The index of the command, or -1 if the options are invalid.
+ */
+static int parseParallel(char **arguments, int *jobs, int *verbose)
+{
+    char *end;
+    long value;
+    int index;
+
+    value = sysconf(_SC_NPROCESSORS_ONLN);
+    *jobs = value > 0 && value <= MAXIMUM_PARALLEL_JOBS ? value : MAXIMUM_PARALLEL_JOBS;
+    *verbose = 0;
+
+    for (index = 1; arguments[index] != NULL && (strcmp(arguments[index], "-j") == 0 || strcmp(arguments[index], "-v") == 0); index++)
+    {
+        if (arguments[index][1] == 'v')
+        {
+            *verbose = 1;
+            continue;
+        }
+
+        if (arguments[++index] == NULL)
+        {
+            fprintf(stderr, "-j: Error. Missing number\n");
+            return -1;
+        }
+
+        value = strtol(arguments[index], &end, 10);
+
+        if (*end != '\0' || end == arguments[index] || value < 1 || value > MAXIMUM_PARALLEL_JOBS)
+        {
+            fprintf(stderr, "%s: Error. Invalid number\n", arguments[index]);
+            return -1;
+        }
+
+        *jobs = value;
+    }
+
+    return index;
+}
+
+/**
+ * Read the items of `parallel` from the standard input, one per line.
+ *
+ * @param arena A pointer to the arena where the input is kept, which the
+ * items point into.
+ * @param count A pointer where the number of items is stored.
+ * @return The heap allocated array of items.
+ */
+static char **readItems(tarena *arena, int *count)
+{
+    char **items;
+    char *line, *end;
+    ssize_t bytes;
+    int size;
+
+    for (;;)
+    {
+        reserve(arena, RECORD_BLOCK);
+        bytes = read(STDIN_FILENO, arena->data + arena->size, RECORD_BLOCK);
+
+        if (bytes < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (bytes <= 0)
+        {
+            break;
+        }
+
+        arena->size += bytes;
+    }
+
+    // The last line may lack its newline
+    append(arena, "\n", 1);
+
+    size = 0;
+
+    for (line = arena->data; line < arena->data + arena->size; line = end + 1)
+    {
+        end = memchr(line, '\n', arena->data + arena->size - line);
+        size += end > line;
+    }
+
+    items = malloc(sizeof(char *) * (size + 1));
+    *count = 0;
+
+    for (line = arena->data; line < arena->data + arena->size; line = end + 1)
+    {
+        end = memchr(line, '\n', arena->data + arena->size - line);
+        *end = '\0';
+
+        if (end > line)
+        {
+            items[(*count)++] = line;
+        }
+    }
+
+    items[*count] = NULL;
+
+    return items;
+}
+
+/**
+ * Start the command of `parallel` for an item, with its standard output and
+ * error captured through pipes and its input read from `/dev/null`, so the
+ * commands never compete for the input of `parallel`.
+ *
+ * @param task A pointer to the task, whose `pid` is set to -1 if the command
+ * could not be started.
+ * @param descriptors The process file descriptor, output and error of the
+ * task, which are opened.
+ * @param command The `NULL` terminated array of arguments of the command.
+ * @param item The item.
+ * @param environment The `NULL` terminated array of exported variables.
+ */
+static void startTask(ttask *task, struct pollfd *descriptors, char **command, const char *item, char **environment)
+{
+    int files[STANDARD_FILES][PIPE];
+    sigset_t interrupts;
+    char **arguments;
+    int count, index, placed;
+
+    task->status = -1;
+    task->pid = -1;
+    clock_gettime(CLOCK_MONOTONIC, &task->start);
+
+    for (index = STDOUT_FILENO; index < STANDARD_FILES; index++)
+    {
+        if (pipe2(files[index], O_CLOEXEC) != 0)
+        {
+            fprintf(stderr, "%s: Error. %s\n", PARALLEL, strerror(errno));
+
+            if (index > STDOUT_FILENO)
+            {
+                close(files[STDOUT_FILENO][PIPE_READ]);
+                close(files[STDOUT_FILENO][PIPE_WRITE]);
+            }
+
+            task->status = SPAWN_FAILURE;
+            return;
+        }
+    }
+
+    task->pid = fork();
+
+    if (task->pid == FORK_CHILD)
+    {
+        // The mask blocking `SIGINT` in `parallel` survives `execve()`
+        sigemptyset(&interrupts);
+        sigaddset(&interrupts, SIGINT);
+        sigprocmask(SIG_UNBLOCK, &interrupts, NULL);
+
+        index = open("/dev/null", FILE_READ);
+        dup2(index, STDIN_FILENO);
+        dup2(files[STDOUT_FILENO][PIPE_WRITE], STDOUT_FILENO);
+        dup2(files[STDERR_FILENO][PIPE_WRITE], STDERR_FILENO);
+
+        count = countArguments(command);
+        arguments = malloc(sizeof(char *) * (count + 2));
+        placed = 0;
+
+        for (index = 0; index < count; index++)
+        {
+            arguments[index] = placeItem(command[index], item);
+            placed = placed || arguments[index] != command[index];
+        }
+
+        if (!placed)
+        {
+            arguments[count++] = (char *)item;
+        }
+
+        arguments[count] = NULL;
+
+        execute(arguments, environment);
+    }
+
+    for (index = STDOUT_FILENO; index < STANDARD_FILES; index++)
+    {
+        close(files[index][PIPE_WRITE]);
+        descriptors[index].fd = task->pid > 0 ? files[index][PIPE_READ] : NO_FILE;
+
+        if (task->pid < 0)
+        {
+            close(files[index][PIPE_READ]);
+        }
+    }
+
+    if (task->pid < 0)
+    {
+        fprintf(stderr, "fork: Error. %s\n", strerror(errno));
+        task->status = SPAWN_FAILURE;
+        return;
+    }
+
+    // Without a process file descriptor, the command is reaped once its
+    // output ends
+    descriptors[TASK_PROCESS].fd = syscall(SYS_pidfd_open, task->pid, 0);
+}
+
+/**
+ * Replace every `{}` of a word of the command of `parallel` by an item.
+ *
+ * @param word The word.
+ * @param item The item.
+ * @return The heap allocated word with the item, or the word itself if it
+ * has no `{}`.
+ */
+static char *placeItem(const char *word, const char *item)
+{
+    tarena arena;
+    const char *found;
+
+    if (strstr(word, ITEM_PLACEHOLDER) == NULL)
+    {
+        return (char *)word;
+    }
+
+    arena.data = NULL;
+    arena.size = 0;
+    arena.capacity = 0;
+
+    while ((found = strstr(word, ITEM_PLACEHOLDER)) != NULL)
+    {
+        append(&arena, word, found - word);
+        append(&arena, item, strlen(item));
+        word = found + strlen(ITEM_PLACEHOLDER);
+    }
+
+    append(&arena, word, strlen(word) + 1);
+
+    return arena.data;
+}
+
+/**
+ * Write the output and error of a finished command of `parallel`, report
+ * its item if asked to, and free its slot.
+ *
+ * @param task A pointer to the task.
+ * @param descriptors The process file descriptor, output and error of the
+ * task, which are all closed.
+ * @param items The items.
+ * @param verbose Flag indicating whether the item is reported.
+ * @param failed A pointer to the index of the first item that failed, or
+ * -1.
+ * @param status A pointer to the exit status of the first item that failed.
+ */
+static void finishTask(ttask *task, struct pollfd *descriptors, char **items, const int verbose, int *failed, int *status)
+{
+    long elapsed;
+    int result;
+
+    if (task->status < 0 && waitpid(task->pid, &result, 0) > 0)
+    {
+        task->status = exitStatus(result);
+    }
+
+    deliver(STDOUT_FILENO, task->captured[STDOUT_FILENO].data, task->captured[STDOUT_FILENO].size);
+    deliver(STDERR_FILENO, task->captured[STDERR_FILENO].data, task->captured[STDERR_FILENO].size);
+    task->captured[STDOUT_FILENO].size = 0;
+    task->captured[STDERR_FILENO].size = 0;
+
+    if (verbose)
+    {
+        elapsed = milliseconds(&task->start);
+        fprintf(stderr, "%i\t%i\t%li.%03li s\t%s\n", task->item + 1, task->status, elapsed / 1000, elapsed % 1000, items[task->item]);
+    }
+
+    if (task->status != EXIT_SUCCESS && (*failed < 0 || task->item < *failed))
+    {
+        *failed = task->item;
+        *status = task->status;
+    }
+
+    task->pid = 0;
+    descriptors[TASK_PROCESS].fd = NO_FILE;
+}
+
+/**
+ * Changes the current working directory.
+ *
+ * Changes the current working directory to the specified directory. If no
+ * directory is provided (NULL), it changes to the HOME directory.
+ *
+ * @param directory The path of the target directory. If NULL, changes to the
+ * HOME directory.
+ * @param variables A pointer to the structure holding the shell variables.
+ * @return `EXIT_SUCCESS` if the directory was changed, `EXIT_FAILURE`
+ * otherwise.
+ */
+static int mshcd(const char *directory, tvariables *variables)
+{
+    if (directory == NULL)
+    {
+        directory = getVariable(variables, HOME, strlen(HOME));
+
+        if (directory == NULL)
+        {
+            fprintf(stderr, "cd: Error. HOME not set\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (chdir(directory) != 0)
+    {
+        fprintf(stderr, "%s: Error. %s\n", directory, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Set the umask value of the commands based on the provided mask and update
+ * the formatted mask. The mask of the shell process itself is left alone.
+ *
+ * @param mask The octal string representing the new umask value.
+ * @param fileMask Pointer to the variable to store the new umask value.
+ * @param formattedMask Pointer to the variable to store the formatted mask.
+ * @return `EXIT_SUCCESS` if the mask is valid, `EXIT_FAILURE` otherwise.
+ */
+static int mshumask(const char *mask, mode_t *fileMask, int *formattedMask)
+{
+    int mappedMask;
+
+    if (mask == NULL)
+    {
+        printMask(*formattedMask);
+        return EXIT_SUCCESS;
+    }
+
+    if (!octal(mask))
+    {
+        fprintf(stderr, "%s: Error. Invalid argument\n", mask);
+        return EXIT_FAILURE;
+    }
+
+    sscanf(mask, "%o", &mappedMask);
+    *fileMask = mappedMask;
+
+    *formattedMask = atoi(mask);
+    printMask(*formattedMask);
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Prints the octal representation of a file permissions mask.
+ *
+ * This function takes an integer `mask` representing a file permissions mask
+ * and prints its octal representation. It ensures that the printed octal
+ * number always consists of at least four digits by padding with leading zeros
+ * if needed.
+ *
+ * @param mask An integer representing the file permissions mask.
+ *
+ * Example:
+ *   printMask(644);  // Output: 0644
+ *   printMask(7);    // Output: 0007
+ */
+static void printMask(const int mask)
+{
+    int auxiliarMask;
+    int zeros;
+    int _;
+
+    auxiliarMask = mask;
+    zeros = 4;
+
+    // Calculate the number of leading zeros needed
+    while (auxiliarMask > 0)
+    {
+        auxiliarMask = auxiliarMask / 10;
+        zeros--;
+    }
+
+    // Print leading zeros
+    for (_ = 0; _ < zeros; _++)
+    {
+        printf("0");
+    }
+
+    printf("%i\n", mask);
+}
+
+/**
+ * Check if a given string represents a valid octal number.
+ *
+ * Ensure that the string is not NULL, has a length of at most 4 characters,
+ * and each character represents a valid octal digit (0-7).
+ *
+ * @param number The string to be checked for octal validity.
+ * @return 1 if the string is a valid octal number, 0 otherwise.
+ */
+static int octal(const char *number)
+{
+    int length;
+    int index;
+    int mappedDigit;
+
+    if (number == NULL)
+    {
+        return 0;
+    }
+
+    length = strlen(number);
+
+    if (length > 4)
+    {
+        return 0;
+    }
+
+    for (index = 0; index < length; index++)
+    {
+        mappedDigit = number[index] - 48;
+
+        if (mappedDigit < 0 || mappedDigit > 7)
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * Terminate all running processes associated with active jobs so the shell
+ * can exit.
+ *
+ * Sends `SIGTERM` to the process group of each job that has not finished
+ * yet, so its commands get the chance to clean up, and waits for them on
+ * process file descriptors for at most `MSH_EXIT_TIMEOUT` milliseconds. The
+ * groups of the jobs still running after that, including the ones where only
+ * adopted descendants are left, are killed with `SIGKILL`.
+ * Finished jobs are skipped, since the identifier of their group could
+ * already belong to another process. Reports how every job ended and how long
+ * the shutdown took, then empties the job list. The process itself is not
+ * ended, since it may be a program embedding the shell, which learns about
+ * it from `msh_exited()`.
+ *
+ * @param jobs A pointer to the structure representing the list of active jobs.
+ * @param variables A pointer to the structure holding the shell variables.
+ * @return `EXIT_SUCCESS`.
+ */
+static int mshexit(tjobs *jobs, tvariables *variables)
+{
+    struct pollfd descriptors[MAXIMUM_JOB_LIST_SIZE * MAXIMUM_PID_LIST_SIZE];
+    tprocess *processes[MAXIMUM_JOB_LIST_SIZE * MAXIMUM_PID_LIST_SIZE];
+    int signals[MAXIMUM_JOB_LIST_SIZE];
+    struct timespec start;
+    const char *timeoutValue;
+    int timeout;
+    int j, index, size;
+    int terminated, killed;
+    tjob *job;
+
+    timeoutValue = getVariable(variables, EXIT_TIMEOUT, strlen(EXIT_TIMEOUT));
+    timeout = timeoutValue != NULL ? atoi(timeoutValue) : DEFAULT_EXIT_TIMEOUT;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    reap(jobs);
+
+    size = 0;
+
+    for (j = 0; j < jobs->size; j++)
+    {
+        job = &jobs->list[j];
+        signals[j] = 0;
+
+        if (finished(job, jobs->subreaper))
+        {
+            continue;
+        }
+
+        killpg(job->pgid, SIGTERM);
+        signals[j] = SIGTERM;
+
+        // Stopped commands only act on the signal once resumed
+        if (job->stopped)
+        {
+            killpg(job->pgid, SIGCONT);
+        }
+
+        for (index = 0; index < job->size; index++)
+        {
+            if (!job->processes[index].reaped)
+            {
+                processes[size] = &job->processes[index];
+                descriptors[size].fd = syscall(SYS_pidfd_open, processes[size]->pid, 0);
+                descriptors[size].events = POLLIN;
+                size++;
+            }
+        }
+    }
+
+    if (size > 0)
+    {
+        waitExit(descriptors, processes, size, &start, timeout);
+    }
+
+    // Adopted descendants that exited meanwhile leave the group empty
+    reap(jobs);
+
+    while (jobs->subreaper && milliseconds(&start) < timeout && running(jobs, signals) > 0)
+    {
+        poll(NULL, 0, ORPHAN_POLL_INTERVAL);
+        reap(jobs);
+    }
+
+    for (j = 0; j < jobs->size; j++)
+    {
+        job = &jobs->list[j];
+
+        if (signals[j] != 0 && !finished(job, jobs->subreaper))
+        {
+            killpg(job->pgid, KILL);
+            signals[j] = SIGKILL;
+
+            for (index = 0; index < job->size; index++)
+            {
+                if (!job->processes[index].reaped)
+                {
+                    waitProcess(&job->processes[index]);
+                }
+            }
+        }
+    }
+
+    terminated = 0;
+    killed = 0;
+
+    for (j = 0; j < jobs->size; j++)
+    {
+        job = &jobs->list[j];
+
+        if (signals[j] == SIGKILL)
+        {
+            printf("[%i] Killed\t%s", j + 1, job->instruction);
+            killed++;
+        }
+        else if (signals[j] == SIGTERM)
+        {
+            printf("[%i] Terminated\t%s", j + 1, job->instruction);
+            terminated++;
+        }
+    }
+
+    if (terminated + killed > 0)
+    {
+        printf("exit: %i jobs terminated, %i killed in %li ms\n", terminated, killed, milliseconds(&start));
+    }
+
+    for (j = 0; j < jobs->size; j++)
+    {
+        releaseCgroup(&jobs->list[j], jobs);
+    }
+
+    jobs->size = 0;
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Wait for the processes signalled by `exit` until all of them have finished
+ * or the timeout expires, reaping each one as soon as its process file
+ * descriptor becomes readable.
+ *
+ * Processes whose descriptor could not be opened are only checked once the
+ * timeout expires.
+ *
+ * @param descriptors The process file descriptors to be polled, which are
+ * closed before returning.
+ * @param processes The processes the descriptors refer to.
+ * @param size The number of descriptors.
+ * @param start The moment the shutdown started.
+ * @param timeout The number of milliseconds to wait since `start`.
+ * @return The number of processes that have not finished.
+ */
+static int waitExit(struct pollfd *descriptors, tprocess **processes, const int size, const struct timespec *start, const int timeout)
+{
+    int pending;
+    int remaining;
+    int index;
+
+    pending = size;
+
+    while (pending > 0 && (remaining = timeout - milliseconds(start)) > 0)
+    {
+        if (poll(descriptors, size, remaining) < 0 && errno != EINTR)
+        {
+            break;
+        }
+
+        for (index = 0; index < size; index++)
+        {
+            if (descriptors[index].fd < 0 || descriptors[index].revents == 0)
+            {
+                continue;
+            }
+
+            if (wait4(processes[index]->pid, &processes[index]->status, WNOHANG, &processes[index]->usage) > 0)
+            {
+                processes[index]->reaped = 1;
+            }
+
+            close(descriptors[index].fd);
+            descriptors[index].fd = NO_FILE;
+            pending--;
+        }
+    }
+
+    pending = 0;
+
+    for (index = 0; index < size; index++)
+    {
+        if (descriptors[index].fd >= 0)
+        {
+            close(descriptors[index].fd);
+        }
+
+        if (!processes[index]->reaped && wait4(processes[index]->pid, &processes[index]->status, WNOHANG, &processes[index]->usage) > 0)
+        {
+            processes[index]->reaped = 1;
+        }
+
+        pending += !processes[index]->reaped;
+    }
+
+    return pending;
+}
+
+/**
+ * Count the jobs signalled by `exit` that have not finished yet.
+ *
+ * @param jobs A pointer to the structure representing the list of active jobs.
+ * @param signals The signal sent to each job, or 0 if it was not signalled.
+ * @return The number of jobs still running.
+ */
+static int running(tjobs *jobs, const int *signals)
+{
+    int j;
+    int count;
+
+    count = 0;
+
+    for (j = 0; j < jobs->size; j++)
+    {
+        count += signals[j] != 0 && !finished(&jobs->list[j], jobs->subreaper);
+    }
+
+    return count;
+}
+
+/**
+ * Get the number of milliseconds elapsed since a given moment of the
+ * monotonic clock.
+ *
+ * @param start The moment to be measured from.
+ * @return The number of milliseconds elapsed.
+ */
+static long milliseconds(const struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (now.tv_sec - start->tv_sec) * 1000 + (now.tv_nsec - start->tv_nsec) / 1000000;
+}
+
+/**
+ * Display the status of jobs in the provided job list.
+ *
+ * Checks the status of each job in the list and prints whether it is done,
+ * stopped or running.
+ *
+ * If a job is done, it prints its completion status, or its exit status if
+ * its last command failed, and saves it in `finishedJobs` local variable to
+ * remove it later.
+ *
+ * @param option The first argument of the command, `-l` to also print the
+ * process group and resource usage of every job, or NULL.
+ * @param jobs A pointer to the structure representing the list of active jobs.
+ * @return `EXIT_SUCCESS`, or `EXIT_FAILURE` if the option is not valid.
+ */
+static int mshjobs(const char *option, tjobs *jobs)
+{
+    int j, jobsSize, formattedJ;
+    tjob *job;
+    int finishedJobs[MAXIMUM_JOB_LIST_SIZE];
+    int finishedJobsSize = 0;
+    int status;
+    int longListing;
+
+    longListing = option != NULL && strcmp(option, LONG_LISTING) == 0;
+
+    if (option != NULL && !longListing)
+    {
+        fprintf(stderr, "%s: Error. Invalid option\n", option);
+        return EXIT_FAILURE;
+    }
+
+    reap(jobs);
+
+    jobsSize = jobs->size;
+
+    for (j = 0; j < jobsSize; j++)
+    {
+        job = &jobs->list[j];
+
+        formattedJ = j + 1;
+
+        if (finished(job, jobs->subreaper))
+        {
+            status = jobStatus(job);
+
+            if (status == EXIT_SUCCESS)
+            {
+                printf("[%i] Done\t%s", formattedJ, job->instruction);
+            }
+            else
+            {
+                printf("[%i] Exit %i\t%s", formattedJ, status, job->instruction);
+            }
+
+            // Jobs with a callback are removed once it is called
+            if (job->callback == NULL)
+            {
+                finishedJobs[finishedJobsSize] = j;
+                finishedJobsSize = (finishedJobsSize + 1) % MAXIMUM_JOB_LIST_SIZE;
+            }
+        }
+        else if (job->stopped)
+        {
+            printf("[%i] Stopped\t%s", formattedJ, job->instruction);
+        }
+        else
+        {
+            printf("[%i] Running\t%s", formattedJ, job->instruction);
+        }
+
+        if (longListing)
+        {
+            printUsage(job);
+            printCgroup(job);
+        }
+    }
+
+    for (j = 0; j < finishedJobsSize; j++)
+    {
+        delete (finishedJobs[j], jobs);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Print the process group of a job and the resources used by its reaped
+ * processes, including the descendants adopted in subreaper mode.
+ *
+ * @param job The structure representing the job.
+ */
+static void printUsage(const tjob *job)
+{
+    struct rusage total;
+    int index;
+    int processes;
+
+    total = job->orphanUsage;
+    processes = job->orphans;
+
+    for (index = 0; index < job->size; index++)
+    {
+        if (job->processes[index].reaped)
+        {
+            addUsage(&total, &job->processes[index].usage);
+            processes++;
+        }
+    }
+
+    printf("\tpgid %i, %i processes reaped, user %li.%03li s, system %li.%03li s, maximum resident set %li KB\n",
+           job->pgid, processes,
+           (long)total.ru_utime.tv_sec, (long)total.ru_utime.tv_usec / 1000,
+           (long)total.ru_stime.tv_sec, (long)total.ru_stime.tv_usec / 1000,
+           total.ru_maxrss);
+}
+
+/**
+ * Check if a job has completed.
+ *
+ * A job is considered finished when all of its commands have been reaped,
+ * either by `reap()` or by waiting for them in the foreground. In subreaper
+ * mode its process group must also be empty, so descendants that outlived
+ * the commands keep the job running.
+ *
+ * @param job The structure representing the job.
+ * @param subreaper Flag indicating whether the shell is in subreaper mode.
+ * @return 1 if all commands of the job have finished, 0 otherwise.
+ */
+static int finished(tjob *job, const int subreaper)
+{
+    int index;
+    int jobSize;
+
+    if (job->finished == 1)
+    {
+        return 1;
+    }
+
+    jobSize = job->size;
+
+    for (index = 0; index < jobSize; index++)
+    {
+        if (!job->processes[index].reaped)
+        {
+            return 0;
+        }
+    }
+
+    if (subreaper && kill(-job->pgid, 0) == 0)
+    {
+        return 0;
+    }
+
+    job->finished = 1;
+
+    return 1;
+}
+
+/**
+ * Execute the specified job in the foreground, waiting for its completion.
+ *
+ * Take a job identifier and a pointer to the shell state. It brings the
+ * specified job to the foreground, giving it the terminal and resuming it if
+ * it was stopped, waits for its completion, and then updates the job
+ * information.
+ *
+ * If the specified job identifier is invalid or the job has already terminated,
+ * appropriate error messages are displayed.
+ *
+ * @param job A string representing the job identifier or number to be brought
+ * to the foreground, optionally prefixed by `%`.
+ * @param shell A pointer to the structure representing the shell state.
+ * @return The exit status of the last command of the job, `SIGNAL_STATUS`
+ * plus the stop signal if it was stopped again, or `EXIT_FAILURE` if the job
+ * does not exist.
+ */
+static int mshfg(const char *job, tshell *shell)
+{
+    msh_result result;
+    msh_callback callback;
+    void *data;
+    int mappedJob;
+    tjob *ranJob;
+    tjobs *jobs;
+    int status;
+    int stopSignal;
+
+    if (job == NULL)
+    {
+        return mshfg("1", shell);
+    }
+
+    jobs = &shell->jobs;
+
+    if (jobs->size == 0)
+    {
+        printf("fg: There are no jobs available\n");
+        return EXIT_FAILURE;
+    }
+
+    mappedJob = jobNumber(job, jobs);
+
+    if (mappedJob < 0)
+    {
+        fprintf(stderr, "fg: Error. No such job\n");
+        return EXIT_FAILURE;
+    }
+
+    reap(jobs);
+
+    ranJob = &jobs->list[mappedJob];
+
+    if (finished(ranJob, jobs->subreaper))
+    {
+        printf("fg: job has terminated\n");
+        printf("[%i] Done\t%s", mappedJob + 1, ranJob->instruction);
+    }
+    else
+    {
+        printf("%s", ranJob->instruction);
+        fflush(stdout);
+
+        stopSignal = waitJob(ranJob, shell, ranJob->stopped);
+
+        if (stopSignal != 0)
+        {
+            printf("\n[%i] Stopped\t%s", mappedJob + 1, ranJob->instruction);
+            return SIGNAL_STATUS + stopSignal;
+        }
+    }
+
+    status = jobStatus(ranJob);
+
+    collect(ranJob, &result);
+    callback = ranJob->callback;
+    data = ranJob->data;
+
+    delete (mappedJob, jobs);
+
+    // A job started with `msh_start()` still reports its outcome
+    if (callback != NULL)
+    {
+        callback(shell, mappedJob + 1, &result, data);
+    }
+
+    return status;
+}
+
+/**
+ * Resume a stopped job in the background.
+ *
+ * @param job A string representing the job identifier or number to be
+ * resumed, optionally prefixed by `%`. If NULL, the most recent stopped job is
+ * resumed.
+ * @param jobs A pointer to the structure representing the list of active jobs.
+ * @return `EXIT_SUCCESS` if the job is running in background, `EXIT_FAILURE`
+ * if the job does not exist or has already terminated.
+ */
+static int mshbg(const char *job, tjobs *jobs)
+{
+    int mappedJob;
+    tjob *resumedJob;
+
+    reap(jobs);
+
+    if (job != NULL)
+    {
+        mappedJob = jobNumber(job, jobs);
+    }
+    else
+    {
+        for (mappedJob = jobs->size - 1; mappedJob >= 0; mappedJob--)
+        {
+            if (jobs->list[mappedJob].stopped && !finished(&jobs->list[mappedJob], jobs->subreaper))
+            {
+                break;
+            }
+        }
+    }
+
+    if (mappedJob < 0)
+    {
+        fprintf(stderr, "bg: Error. No such job\n");
+        return EXIT_FAILURE;
+    }
+
+    resumedJob = &jobs->list[mappedJob];
+
+    if (finished(resumedJob, jobs->subreaper))
+    {
+        printf("bg: job has terminated\n");
+        return EXIT_FAILURE;
+    }
+
+    if (resumedJob->stopped)
+    {
+        killpg(resumedJob->pgid, SIGCONT);
+        resumedJob->stopped = 0;
+    }
+
+    printf("[%i] Running\t%s", mappedJob + 1, resumedJob->instruction);
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Send a signal to jobs or processes.
+ *
+ * Every argument is either a job number prefixed by `%`, whose whole process
+ * group receives the signal with a single `killpg()`, or a process
+ * identifier. The signal is `SIGTERM` unless the first argument is `-NAME`
+ * or `-NUMBER`. Stopped jobs are also resumed, so they can act on the signal.
+ *
+ * Example:
+ *   kill %1
+ *   kill -STOP %2 1234
+ *
+ * @param arguments The `NULL` terminated array of arguments of the command.
+ * @param jobs A pointer to the structure representing the list of active jobs.
+ * @return `EXIT_SUCCESS` if every signal was sent, `EXIT_FAILURE` otherwise.
+ */
+static int mshkill(char **arguments, tjobs *jobs)
+{
+    int sent;
+    int index;
+    int mappedJob;
+    int status;
+    tjob *job;
+
+    sent = SIGTERM;
+    index = 1;
+
+    if (arguments[index] != NULL && arguments[index][0] == '-')
+    {
+        sent = signalNumber(arguments[index] + 1);
+
+        if (sent < 0)
+        {
+            fprintf(stderr, "%s: Error. Invalid signal\n", arguments[index]);
+            return EXIT_FAILURE;
+        }
+
+        index++;
+    }
+
+    if (arguments[index] == NULL)
+    {
+        fprintf(stderr, "kill: Error. Missing job or process identifier\n");
+        return EXIT_FAILURE;
+    }
+
+    reap(jobs);
+
+    status = EXIT_SUCCESS;
+
+    for (; arguments[index] != NULL; index++)
+    {
+        if (arguments[index][0] != JOB_PREFIX)
+        {
+            if (kill(atoi(arguments[index]), sent) != 0)
+            {
+                fprintf(stderr, "%s: Error. %s\n", arguments[index], strerror(errno));
+                status = EXIT_FAILURE;
+            }
+
+            continue;
+        }
+
+        mappedJob = jobNumber(arguments[index], jobs);
+
+        if (mappedJob < 0 || finished(&jobs->list[mappedJob], jobs->subreaper))
+        {
+            fprintf(stderr, "%s: Error. No such job\n", arguments[index]);
+            status = EXIT_FAILURE;
+            continue;
+        }
+
+        job = &jobs->list[mappedJob];
+
+        if (killpg(job->pgid, sent) != 0)
+        {
+            fprintf(stderr, "%s: Error. %s\n", arguments[index], strerror(errno));
+            status = EXIT_FAILURE;
+            continue;
+        }
+
+        if (job->stopped && sent != SIGSTOP && sent != SIGTSTP && sent != SIGTTIN && sent != SIGTTOU)
+        {
+            killpg(job->pgid, SIGCONT);
+            job->stopped = 0;
+        }
+    }
+
+    return status;
+}
+
+/**
+ * Get the position in the list of active jobs of a job number.
+ *
+ * @param job A string representing the job number, optionally prefixed by
+ * `%`.
+ * @param jobs A pointer to the structure representing the list of active jobs.
+ * @return The position of the job, or -1 if there is no such job.
+ */
+static int jobNumber(const char *job, tjobs *jobs)
+{
+    int mappedJob;
+
+    if (job[0] == JOB_PREFIX)
+    {
+        job++;
+    }
+
+    mappedJob = atoi(job) - 1;
+
+    if (mappedJob < 0 || mappedJob > jobs->size - 1)
+    {
+        return -1;
+    }
+
+    return mappedJob;
+}
+
+/**
+ * Get the number of a signal from its name, with or without the `SIG`
+ * prefix, or from its number.
+ *
+ * @param name The name or number of the signal.
+ * @return The number of the signal, or -1 if it is not valid.
+ */
+static int signalNumber(const char *name)
+{
+    static const char *names[] = {"HUP", "INT", "QUIT", "KILL", "USR1", "USR2", "PIPE", "ALRM", "TERM", "CHLD", "CONT", "STOP", "TSTP", "TTIN", "TTOU"};
+    static const int numbers[] = {SIGHUP, SIGINT, SIGQUIT, SIGKILL, SIGUSR1, SIGUSR2, SIGPIPE, SIGALRM, SIGTERM, SIGCHLD, SIGCONT, SIGSTOP, SIGTSTP, SIGTTIN, SIGTTOU};
+    int number;
+    int index;
+
+    if (name[0] >= '0' && name[0] <= '9')
+    {
+        number = atoi(name);
+        return number < NSIG ? number : -1;
+    }
+
+    if (strncmp(name, "SIG", 3) == 0)
+    {
+        name += 3;
+    }
+
+    for (index = 0; index < (int)(sizeof(numbers) / sizeof(numbers[0])); index++)
+    {
+        if (strcmp(name, names[index]) == 0)
+        {
+            return numbers[index];
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Wait in the foreground for the processes of a job that have not been
+ * reaped yet.
+ *
+ * If job control is enabled, the job is given the terminal while it runs and
+ * the shell takes it back afterwards. Waiting stops as soon as a process of
+ * the job is stopped, since the whole group is stopped by `Ctrl+Z`.
+ *
+ * The processes are reaped in the order they finish by waiting for the
+ * process group, so a command that exits early, like `head` in
+ * `yes | head -1`, gets the command writing to it terminated at once. Only
+ * the commands that left the group, if any, are waited for one by one.
+ *
+ * @param job The structure representing the job.
+ * @param shell A pointer to the structure representing the shell state.
+ * @param resume Flag indicating whether the job must be sent `SIGCONT`.
+ * @return The signal that stopped the job, or 0 if every process finished.
+ */
+static int waitJob(tjob *job, tshell *shell, const int resume)
+{
+    struct rusage usage;
+    tprocess *process;
+    pid_t pid;
+    int status;
+    int index;
+    int stopSignal;
+
+    shell->foregroundGroup = job->pgid;
+
+    if (shell->interactive)
+    {
+        tcsetpgrp(TERMINAL, job->pgid);
+    }
+
+    if (resume)
+    {
+        killpg(job->pgid, SIGCONT);
+        job->stopped = 0;
+    }
+
+    stopSignal = 0;
+
+    while (stopSignal == 0 && runningProcesses(job) > 0)
+    {
+        do
+        {
+            pid = wait4(-job->pgid, &status, WUNTRACED, &usage);
+        } while (pid < 0 && errno == EINTR);
+
+        if (pid < 0)
+        {
+            break;
+        }
+
+        if (WIFSTOPPED(status))
+        {
+            stopSignal = WSTOPSIG(status);
+            break;
+        }
+
+        for (index = 0; index < job->size && job->processes[index].pid != pid; index++)
+        {
+        }
+
+        // A descendant adopted in subreaper mode
+        if (index == job->size)
+        {
+            job->orphans++;
+            addUsage(&job->orphanUsage, &usage);
+            continue;
+        }
+
+        process = &job->processes[index];
+        process->reaped = 1;
+        process->status = status;
+        process->usage = usage;
+
+        terminateUpstream(job, index);
+    }
+
+    for (index = 0; index < job->size && stopSignal == 0; index++)
+    {
+        process = &job->processes[index];
+
+        if (!process->reaped)
+        {
+            stopSignal = waitProcess(process);
+        }
+    }
+
+    if (shell->interactive)
+    {
+        tcsetpgrp(TERMINAL, shell->pgid);
+
+        // The terminal echoed `^C` but the shell did not receive the stopSignal
+        process = &job->processes[job->size - 1];
+
+        if (process->reaped && WIFSIGNALED(process->status) && WTERMSIG(process->status) == SIGINT)
+        {
+            printf("\n");
+        }
+    }
+
+    shell->foregroundGroup = 0;
+
+    job->stopped = stopSignal != 0;
+
+    return stopSignal;
+}
+
+/**
+ * Terminate the command writing to a command of a job that finished.
+ *
+ * Without a reader, the writer would only be sent `SIGPIPE` by its next
+ * write, so a producer that computes for long between writes keeps running
+ * for nothing. The signal is the same, so its status is the usual one of a
+ * command writing to a closed pipe, and its own writer is terminated in turn
+ * once it is reaped.
+ *
+ * The writer is only terminated while its standard output is still a pipe.
+ * Programs such as `grep` close it before exiting, which is how the reader
+ * saw the end of its input, and their own status must not be replaced.
+ *
+ * @param job The structure representing the job.
+ * @param index The position of the command that finished within the job.
+ */
+static void terminateUpstream(const tjob *job, const int index)
+{
+    char path[PATH_MAX];
+    char target[PATH_MAX];
+    ssize_t length;
+    pid_t pid;
+
+    if (index == 0 || job->processes[index - 1].reaped)
+    {
+        return;
+    }
+
+    pid = job->processes[index - 1].pid;
+
+    snprintf(path, PATH_MAX, "/proc/%i/fd/%i", pid, STDOUT_FILENO);
+    length = readlink(path, target, PATH_MAX - 1);
+
+    if (length < 0)
+    {
+        return;
+    }
+
+    target[length] = '\0';
+
+    if (strncmp(target, "pipe:", strlen("pipe:")) == 0)
+    {
+        kill(pid, SIGPIPE);
+    }
+}
+
+/**
+ * Get the exit status of a finished job: the one of its last command or,
+ * with the `pipefail` option, the one of its last command that failed.
+ *
+ * @param job The structure representing the job.
+ * @return The exit status of the job.
+ */
+static int jobStatus(const tjob *job)
+{
+    int index;
+
+    for (index = job->size - 1; index > 0 && job->pipefail && exitStatus(job->processes[index].status) == EXIT_SUCCESS; index--)
+    {
+    }
+
+    return exitStatus(job->processes[index].status);
+}
+
+/**
+ * Move a command line stopped in the foreground to the list of active jobs.
+ *
+ * @param job The structure representing the stopped command line.
+ * @param jobs A pointer to the structure representing the list of active jobs.
+ */
+static void stop(const tjob *job, tjobs *jobs)
+{
+    jobs->list[jobs->size] = *job;
+    jobs->size = (jobs->size + 1) % MAXIMUM_JOB_LIST_SIZE;
+
+    printf("\n[%i] Stopped\t%s", jobs->size, job->instruction);
+}
+
+/**
+ * Delete a inactive job from a list of active jobs.
+ *
+ * @param job Inactive job that will be removed from active jobs list.
+ * @param jobs A pointer to the structure representing the list of active jobs.
+ */
+static void delete(const int job, tjobs *jobs)
+{
+    int index, jobsSize;
+
+    jobsSize = jobs->size;
+
+    releaseCgroup(&jobs->list[job], jobs);
+
+    for (index = job; index < jobsSize; index++)
+    {
+        jobs->list[index] = jobs->list[index + 1];
+    }
+
+    jobs->size = (jobs->size - 1) % MAXIMUM_JOB_LIST_SIZE;
+}
+
+/**
+ * Create the empty list of jobs and, if `MSH_SUBREAPER` is set to a nonzero
+ * number, make the shell the subreaper of its descendants. Cgroups are
+ * enabled by `MSH_CGROUPS`.
+ *
+ * @param jobs A pointer to the structure representing the list of jobs.
+ * @param variables A pointer to the structure holding the shell variables.
+ */
+static void initializeJobs(tjobs *jobs, tvariables *variables)
+{
+    const char *subreaper;
+
+    jobs->list = malloc(sizeof(tjob) * MAXIMUM_JOB_LIST_SIZE);
+    jobs->size = 0;
+
+    subreaper = getVariable(variables, SUBREAPER, strlen(SUBREAPER));
+    jobs->subreaper = subreaper != NULL && atoi(subreaper) != 0;
+
+    if (jobs->subreaper && prctl(PR_SET_CHILD_SUBREAPER, 1) != 0)
+    {
+        fprintf(stderr, "%s: Error. %s\n", SUBREAPER, strerror(errno));
+        jobs->subreaper = 0;
+    }
+
+    initializeCgroups(jobs, variables);
+}
+
+/**
+ * Move the shell into a cgroup of its own if `MSH_CGROUPS` is set to a
+ * nonzero number, so every job can be placed in a cgroup beside it.
+ *
+ * The shell moves from the cgroup it was started in, which must be delegated
+ * to the user, to a `shell` leaf inside it, and then enables the controllers
+ * of that cgroup for its children. A controller that cannot be enabled only
+ * disables the limits using it, since `cpu.stat` is always available. If the
+ * shell cannot move, cgroups are disabled and jobs run as usual.
+ *
+ * @param jobs A pointer to the structure representing the list of jobs.
+ * @param variables A pointer to the structure holding the shell variables.
+ */
+static void initializeCgroups(tjobs *jobs, tvariables *variables)
+{
+    static const char *controllers[] = {"+cpu", "+memory", "+io", "+pids"};
+    char path[PATH_MAX];
+    char line[PATH_MAX];
+    const char *value;
+    struct mntent *mount;
+    FILE *file;
+    int length;
+    int index;
+
+    jobs->cgroups = NO_FILE;
+    jobs->cgroupCount = 0;
+
+    value = getVariable(variables, CGROUPS, strlen(CGROUPS));
+    if (value == NULL || atoi(value) == 0)
+    {
+        return;
+    }
+
+    path[0] = '\0';
+
+    // The unified hierarchy is not always mounted at /sys/fs/cgroup
+    file = setmntent(MOUNTS, "r");
+    while (file != NULL && (mount = getmntent(file)) != NULL)
+    {
+        if (strcmp(mount->mnt_type, CGROUP_FILESYSTEM) == 0)
+        {
+            snprintf(path, PATH_MAX, "%s", mount->mnt_dir);
+            break;
+        }
+    }
+
+    if (file != NULL)
+    {
+        endmntent(file);
+    }
+
+    file = fopen(OWN_CGROUP, "r");
+    length = strlen(path);
+
+    while (length > 0 && file != NULL && fgets(line, PATH_MAX, file) != NULL)
+    {
+        if (strncmp(line, "0::", 3) == 0)
+        {
+            line[strcspn(line, "\n")] = '\0';
+            snprintf(path + length, PATH_MAX - length, "%s", line + 3);
+            length = 0;
+        }
+    }
+
+    if (file != NULL)
+    {
+        fclose(file);
+    }
+
+    if (path[0] == '\0' || length != 0)
+    {
+        fprintf(stderr, "%s: Error. The cgroup v2 hierarchy is not mounted\n", CGROUPS);
+        return;
+    }
+
+    jobs->cgroups = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    if (jobs->cgroups < 0 || (mkdirat(jobs->cgroups, SHELL_CGROUP, CGROUP_PERMISSIONS) != 0 && errno != EEXIST) ||
+        writeCgroup(jobs->cgroups, SHELL_CGROUP "/cgroup.procs", "0") != EXIT_SUCCESS)
+    {
+        fprintf(stderr, "%s: Error. %s: %s\n", CGROUPS, path, strerror(errno));
+
+        if (jobs->cgroups >= 0)
+        {
+            close(jobs->cgroups);
+        }
+
+        jobs->cgroups = NO_FILE;
+        return;
+    }
+
+    for (index = 0; index < (int)(sizeof(controllers) / sizeof(controllers[0])); index++)
+    {
+        writeCgroup(jobs->cgroups, "cgroup.subtree_control", controllers[index]);
+    }
+}
+
+/**
+ * Create the cgroup of a job, if cgroups are enabled.
+ *
+ * @param job The structure representing the job, whose `cgroup` field is set
+ * to the directory of its cgroup or to `NO_FILE`.
+ * @param jobs A pointer to the structure representing the list of jobs.
+ */
+static void createCgroup(tjob *job, tjobs *jobs)
+{
+    char name[CGROUP_NAME_LENGTH];
+    int created;
+
+    job->cgroup = NO_FILE;
+
+    if (jobs->cgroups < 0)
+    {
+        return;
+    }
+
+    // Leaves left behind by descendants that outlived their job are skipped
+    do
+    {
+        job->cgroupId = ++jobs->cgroupCount;
+        snprintf(name, CGROUP_NAME_LENGTH, JOB_CGROUP, job->cgroupId);
+        created = mkdirat(jobs->cgroups, name, CGROUP_PERMISSIONS) == 0;
+    } while (!created && errno == EEXIST);
+
+    if (created)
+    {
+        job->cgroup = openat(jobs->cgroups, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    }
+}
+
+/**
+ * Remove the cgroup of a finished job. If some of its descendants are still
+ * running, the cgroup cannot be removed and is left behind.
+ *
+ * @param job The structure representing the job.
+ * @param jobs A pointer to the structure representing the list of jobs.
+ */
+static void releaseCgroup(tjob *job, tjobs *jobs)
+{
+    char name[CGROUP_NAME_LENGTH];
+
+    if (job->cgroup < 0)
+    {
+        return;
+    }
+
+    close(job->cgroup);
+    job->cgroup = NO_FILE;
+
+    snprintf(name, CGROUP_NAME_LENGTH, JOB_CGROUP, job->cgroupId);
+    unlinkat(jobs->cgroups, name, AT_REMOVEDIR);
+}
+
+/**
+ * Fork a child directly into a cgroup.
+ *
+ * `clone3()` with `CLONE_INTO_CGROUP` creates the child inside the cgroup,
+ * so none of its resources are charged elsewhere. On kernels without it, the
+ * child is forked and moves itself into the cgroup before running anything.
+ *
+ * @param cgroup The directory of the cgroup, or `NO_FILE` to simply fork.
+ * @return The process identifier of the child in the parent, 0 in the child,
+ * or -1 if no child could be created.
+ */
+static pid_t spawn(const int cgroup)
+{
+    tcloneargs arguments;
+    pid_t pid;
+
+    if (cgroup < 0)
+    {
+        return fork();
+    }
+
+    memset(&arguments, 0, sizeof(arguments));
+    arguments.flags = CLONE_INTO_CGROUP;
+    arguments.exit_signal = SIGCHLD;
+    arguments.cgroup = cgroup;
+
+    pid = syscall(SYS_clone3, &arguments, sizeof(arguments));
+    if (pid >= 0)
+    {
+        return pid;
+    }
+
+    pid = fork();
+    if (pid == FORK_CHILD)
+    {
+        writeCgroup(cgroup, "cgroup.procs", "0");
+    }
+
+    return pid;
+}
+
+/**
+ * Create a child for a command of a job, retrying with an exponential
+ * backoff while the system is out of processes or memory.
+ *
+ * Between attempts, the children that already finished are reaped, since
+ * they count against `RLIMIT_NPROC` and the pid limits until then.
+ *
+ * @param job The structure representing the job being started.
+ * @param jobs A pointer to the structure representing the list of active jobs.
+ * @return The process identifier of the child in the parent, 0 in the child,
+ * or -1 with `errno` set if no child could be created.
+ */
+static pid_t retrySpawn(tjob *job, tjobs *jobs)
+{
+    struct timespec delay;
+    long backoff;
+    int attempt;
+    pid_t pid;
+
+    backoff = SPAWN_BACKOFF;
+
+    for (attempt = 1;; attempt++)
+    {
+        pid = spawn(job->cgroup);
+
+        if (pid >= 0 || (errno != EAGAIN && errno != ENOMEM) || attempt == SPAWN_ATTEMPTS)
+        {
+            return pid;
+        }
+
+        while (reclaim(job, jobs, WNOHANG))
+        {
+        }
+
+        delay.tv_sec = backoff / NANOSECONDS;
+        delay.tv_nsec = backoff % NANOSECONDS;
+        nanosleep(&delay, NULL);
+
+        backoff *= 2;
+    }
+}
+
+/**
+ * Wait until the commands of a line can be started without exceeding the
+ * maximum number of commands running at once.
+ *
+ * Only processes of running jobs are waited for, since stopped ones would
+ * never finish. A line is always let start when nothing else runs, so a
+ * pipeline longer than the maximum still runs, alone.
+ *
+ * @param job The structure representing the job being started.
+ * @param jobs A pointer to the structure representing the list of active jobs.
+ * @param maximum The maximum number of commands running at once, 0 or less
+ * for no maximum.
+ * @param commands The number of commands of the line.
+ */
+static void admit(tjob *job, tjobs *jobs, const int maximum, const int commands)
+{
+    int others, j;
+
+    if (maximum <= 0)
+    {
+        return;
+    }
+
+    for (;;)
+    {
+        others = 0;
+
+        for (j = 0; j < jobs->size; j++)
+        {
+            if (!jobs->list[j].stopped)
+            {
+                others += runningProcesses(&jobs->list[j]);
+            }
+        }
+
+        if (others == 0 || others + commands <= maximum)
+        {
+            return;
+        }
+
+        if (!reclaim(job, jobs, 0))
+        {
+            return;
+        }
+    }
+}
+
+/**
+ * Reap the finished processes of the shell while a job is being started.
+ *
+ * The job is not in the list of jobs yet, so `reap()` would lose the status
+ * of its commands: they are reaped by their identifier here, and the
+ * processes of the other jobs by `reap()`. When waiting, the process file
+ * descriptors of every running process of the shell are polled, so children
+ * that do not belong to the shell are never waited for.
+ *
+ * @param job The structure representing the job being started.
+ * @param jobs A pointer to the structure representing the list of active jobs.
+ * @param options `WNOHANG` to return at once if no process finished, or 0
+ * to wait for one.
+ * @return 1 if a process was reaped, 0 otherwise.
+ */
+static int reclaim(tjob *job, tjobs *jobs, const int options)
+{
+    struct pollfd *descriptors;
+    tprocess *process;
+    tjob *owner;
+    int before, after, size, j, index;
+
+    for (;;)
+    {
+        before = runningProcesses(job);
+
+        for (j = 0; j < jobs->size; j++)
+        {
+            before += runningProcesses(&jobs->list[j]);
+        }
+
+        for (index = 0; index < job->size; index++)
+        {
+            process = &job->processes[index];
+
+            if (!process->reaped && wait4(process->pid, &process->status, WNOHANG, &process->usage) > 0)
+            {
+                process->reaped = 1;
+                terminateUpstream(job, index);
+            }
+        }
+
+        reap(jobs);
+
+        after = runningProcesses(job);
+
+        for (j = 0; j < jobs->size; j++)
+        {
+            after += runningProcesses(&jobs->list[j]);
+        }
+
+        if (after < before || options & WNOHANG)
+        {
+            return after < before;
+        }
+
+        descriptors = malloc(sizeof(struct pollfd) * (MAXIMUM_JOB_LIST_SIZE + 1) * MAXIMUM_PID_LIST_SIZE);
+        size = 0;
+
+        // The job being started comes last, after every job of the list
+        for (j = 0; j <= jobs->size; j++)
+        {
+            owner = j < jobs->size ? &jobs->list[j] : job;
+
+            for (index = 0; index < owner->size && !owner->stopped; index++)
+            {
+                if (!owner->processes[index].reaped && (descriptors[size].fd = syscall(SYS_pidfd_open, owner->processes[index].pid, 0)) >= 0)
+                {
+                    descriptors[size++].events = POLLIN;
+                }
+            }
+        }
+
+        if (size > 0)
+        {
+            poll(descriptors, size, -1);
+        }
+
+        for (index = 0; index < size; index++)
+        {
+            close(descriptors[index].fd);
+        }
+
+        free(descriptors);
+
+        if (size == 0)
+        {
+            return 0;
+        }
+    }
+}
+
+/**
+ * Count the processes of a job that have not been reaped yet.
+ *
+ * @param job The structure representing the job.
+ * @return The number of processes still running.
+ */
+static int runningProcesses(const tjob *job)
+{
+    int count, index;
+
+    count = 0;
+
+    for (index = 0; index < job->size; index++)
+    {
+        count += !job->processes[index].reaped;
+    }
+
+    return count;
+}
+
+/**
+ * Write a value to a file of a cgroup.
+ *
+ * @param cgroup The directory of the cgroup.
+ * @param name The name of the file, relative to the directory.
+ * @param value The value to be written.
+ * @return `EXIT_SUCCESS` if the value was written, `EXIT_FAILURE` otherwise,
+ * with `errno` set.
+ */
+static int writeCgroup(const int cgroup, const char *name, const char *value)
+{
+    int fd;
+    int written;
+
+    fd = openat(cgroup, name, O_WRONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    written = write(fd, value, strlen(value)) == (ssize_t)strlen(value);
+    close(fd);
+
+    return written ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * Read a statistic of a cgroup, either a file holding a single number, such
+ * as `memory.peak`, or a key of a flat keyed file, such as `cpu.stat`.
+ *
+ * @param cgroup The directory of the cgroup.
+ * @param name The name of the file, relative to the directory.
+ * @param key The key of the statistic, or NULL for a single number.
+ * @param value A pointer where the statistic is stored.
+ * @return `EXIT_SUCCESS` if the statistic was read, `EXIT_FAILURE` otherwise.
+ */
+static int readCgroup(const int cgroup, const char *name, const char *key, unsigned long long *value)
+{
+    char buffer[CGROUP_BUFFER_SIZE];
+    char *line;
+    int length;
+    int fd;
+
+    fd = openat(cgroup, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    length = read(fd, buffer, CGROUP_BUFFER_SIZE - 1);
+    close(fd);
+
+    if (length <= 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    buffer[length] = '\0';
+
+    if (key == NULL)
+    {
+        return sscanf(buffer, "%llu", value) == 1 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    line = buffer;
+
+    while (line != NULL)
+    {
+        if (strncmp(line, key, strlen(key)) == 0 && line[strlen(key)] == ' ')
+        {
+            return sscanf(line + strlen(key), "%llu", value) == 1 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+        line = strchr(line, '\n');
+        if (line != NULL)
+        {
+            line++;
+        }
+    }
+
+    return EXIT_FAILURE;
+}
+
+/**
+ * Print the processor time and the memory used by a job, read from its
+ * cgroup, so every descendant is included even if it was never reaped by
+ * the shell.
+ *
+ * @param job The structure representing the job.
+ */
+static void printCgroup(const tjob *job)
+{
+    unsigned long long user;
+    unsigned long long system;
+    unsigned long long peak;
+
+    if (job->cgroup < 0)
+    {
+        return;
+    }
+
+    if (readCgroup(job->cgroup, "cpu.stat", "user_usec", &user) != EXIT_SUCCESS ||
+        readCgroup(job->cgroup, "cpu.stat", "system_usec", &system) != EXIT_SUCCESS)
+    {
+        return;
+    }
+
+    printf("\tcgroup " JOB_CGROUP ", user %llu.%03llu s, system %llu.%03llu s", job->cgroupId,
+           user / 1000000, user / 1000 % 1000, system / 1000000, system / 1000 % 1000);
+
+    // Only available with the memory controller
+    if (readCgroup(job->cgroup, "memory.peak", NULL, &peak) == EXIT_SUCCESS)
+    {
+        printf(", peak memory %llu KB", peak / 1024);
+    }
+
+    printf("\n");
+}
+
+/**
+ * Limit the resources of a job through its cgroup.
+ *
+ * Handles `job limit %n key=value...`, where the keys are `cpu`, a
+ * percentage of one processor or `max`, `mem`, a size with an optional `K`,
+ * `M`, `G` or `T` suffix or `max`, `io`, a weight from 1 to 10000, and
+ * `pids`, a number of processes or `max`.
+ *
+ * @param arguments The arguments of the command, starting with `job`.
+ * @param jobs A pointer to the structure representing the list of jobs.
+ * @return `EXIT_SUCCESS` if every limit was set, `EXIT_FAILURE` otherwise.
+ */
+static int mshjob(char **arguments, tjobs *jobs)
+{
+    static const char *keys[] = {"cpu", "mem", "io", "pids"};
+    static const char *files[] = {"cpu.max", "memory.max", "io.weight", "pids.max"};
+    char value[CGROUP_BUFFER_SIZE];
+    char *separator;
+    int mappedJob;
+    int index;
+    int key;
+    int status;
+    tjob *job;
+
+    if (arguments[1] == NULL || strcmp(arguments[1], "limit") != 0 || arguments[2] == NULL || arguments[3] == NULL)
+    {
+        fprintf(stderr, "job: Error. Usage: job limit %%n key=value...\n");
+        return EXIT_FAILURE;
+    }
+
+    mappedJob = jobNumber(arguments[2], jobs);
+
+    if (mappedJob < 0)
+    {
+        fprintf(stderr, "job: Error. No such job\n");
+        return EXIT_FAILURE;
+    }
+
+    job = &jobs->list[mappedJob];
+
+    if (job->cgroup < 0)
+    {
+        fprintf(stderr, "job: Error. The job has no cgroup, set %s to enable them\n", CGROUPS);
+        return EXIT_FAILURE;
+    }
+
+    status = EXIT_SUCCESS;
+
+    for (index = 3; arguments[index] != NULL; index++)
+    {
+        separator = strchr(arguments[index], '=');
+
+        for (key = 0; separator != NULL && key < (int)(sizeof(keys) / sizeof(keys[0])); key++)
+        {
+            if ((int)strlen(keys[key]) == separator - arguments[index] && strncmp(arguments[index], keys[key], separator - arguments[index]) == 0)
+            {
+                break;
+            }
+        }
+
+        if (separator == NULL || key == (int)(sizeof(keys) / sizeof(keys[0])))
+        {
+            fprintf(stderr, "%s: Error. Invalid limit\n", arguments[index]);
+            status = EXIT_FAILURE;
+            continue;
+        }
+
+        // The quota of cpu.max is given per period of 100 ms
+        if (strcmp(keys[key], "cpu") == 0 && strcmp(separator + 1, "max") != 0)
+        {
+            snprintf(value, CGROUP_BUFFER_SIZE, "%li %i", atol(separator + 1) * CPU_PERIOD / 100, CPU_PERIOD);
+        }
+        else
+        {
+            snprintf(value, CGROUP_BUFFER_SIZE, "%s", separator + 1);
+        }
+
+        if (writeCgroup(job->cgroup, files[key], value) != EXIT_SUCCESS)
+        {
+            if (errno == ENOENT)
+            {
+                fprintf(stderr, "%s: Error. The controller of %s is not enabled\n", arguments[index], files[key]);
+            }
+            else
+            {
+                fprintf(stderr, "%s: Error. %s: %s\n", arguments[index], files[key], strerror(errno));
+            }
+
+            status = EXIT_FAILURE;
+        }
+    }
+
+    return status;
+}
+
+/**
+ * Display the processor topology, or set the processors a running job may
+ * run on.
+ *
+ * Handles `pin`, which lists the processors of every NUMA node and of every
+ * group sharing a level 3 cache, and `pin %n placement`, where the placement
+ * is the same as the one of the `pin` prefix. Only the processes of the job
+ * started by the shell are moved, with all their threads; the descendants
+ * they already forked keep their processors.
+ *
+ * @param arguments The arguments of the command, starting with `pin`.
+ * @param shell A pointer to the structure representing the shell state.
+ * @return `EXIT_SUCCESS` if the topology was displayed or every process was
+ * moved, `EXIT_FAILURE` otherwise.
+ */
+static int mshpin(char **arguments, tshell *shell)
+{
+    cpu_set_t cpus[MAXIMUM_PID_LIST_SIZE];
+    tplacement placement;
+    int mappedJob;
+    int index;
+    int status;
+    tjob *job;
+
+    if (arguments[1] == NULL)
+    {
+        loadTopology(&shell->topology);
+
+        for (index = 0; index < shell->topology.nodes.size; index++)
+        {
+            printf("node %i: ", index);
+            printCpus(&shell->topology.nodes.domains[index]);
+        }
+
+        for (index = 0; index < shell->topology.caches.size; index++)
+        {
+            printf("l3 %i: ", index);
+            printCpus(&shell->topology.caches.domains[index]);
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+    mappedJob = jobNumber(arguments[1], &shell->jobs);
+
+    if (mappedJob < 0)
+    {
+        fprintf(stderr, "pin: Error. No such job\n");
+        return EXIT_FAILURE;
+    }
+
+    // The job comes before the placement
+    if (parsePlacement(arguments, PLACEMENT + 1, &placement) < 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    job = &shell->jobs.list[mappedJob];
+    placeJob(&placement, job, shell, cpus, job->size);
+
+    status = EXIT_SUCCESS;
+
+    for (index = 0; index < job->size; index++)
+    {
+        if (!job->processes[index].reaped && pinProcess(job->processes[index].pid, &cpus[index]) != EXIT_SUCCESS)
+        {
+            fprintf(stderr, "pin: Error. %i: %s\n", job->processes[index].pid, strerror(errno));
+            status = EXIT_FAILURE;
+        }
+    }
+
+    return status;
+}
+
+/**
+ * Parse the placement given to `pin`: `auto`, `l3`, or lists of processors
+ * such as `0-3,8`, one per command of the pipeline separated by `:`, the last
+ * one applying to the remaining commands.
+ *
+ * @param arguments The arguments of `pin`.
+ * @param index The index of the placement in the arguments.
+ * @param placement A pointer to the structure where the placement is stored.
+ * @return The index of the argument following the placement, or -1 if it is
+ * invalid.
+ */
+static int parsePlacement(char **arguments, const int index, tplacement *placement)
+{
+    char *text;
+    char *end;
+    int valid;
+
+    text = arguments[index];
+
+    if (text == NULL)
+    {
+        fprintf(stderr, "pin: Error. Missing placement\n");
+        return -1;
+    }
+
+    placement->size = 0;
+
+    if (strcmp(text, "auto") == 0)
+    {
+        placement->mode = PIN_AUTO;
+        return index + 1;
+    }
+
+    if (strcmp(text, "l3") == 0)
+    {
+        placement->mode = PIN_L3;
+        return index + 1;
+    }
+
+    placement->mode = PIN_CPUS;
+
+    do
+    {
+        end = strchr(text, STAGE_SEPARATOR);
+        if (end != NULL)
+        {
+            *end = '\0';
+        }
+
+        valid = placement->size < MAXIMUM_PID_LIST_SIZE && parseCpus(text, &placement->stages[placement->size]) == EXIT_SUCCESS;
+
+        if (end != NULL)
+        {
+            *end = STAGE_SEPARATOR;
+        }
+
+        if (!valid)
+        {
+            fprintf(stderr, "%s: Error. Invalid placement\n", arguments[index]);
+            return -1;
+        }
+
+        placement->size++;
+        text = end + 1;
+    } while (end != NULL);
+
+    return index + 1;
+}
+
+/**
+ * Parse a list of processors in the format of `/sys`, such as `0-3,8`.
+ *
+ * @param text The list, which ends at its first character other than a
+ * digit, `-` or `,`.
+ * @param cpus A pointer to the set where the processors are stored.
+ * @return `EXIT_SUCCESS` if the list is valid and not empty, `EXIT_FAILURE`
+ * otherwise.
+ */
+static int parseCpus(const char *text, cpu_set_t *cpus)
+{
+    long first;
+    long last;
+    char *end;
+
+    CPU_ZERO(cpus);
+
+    while (*text >= '0' && *text <= '9')
+    {
+        first = strtol(text, &end, 10);
+        last = first;
+
+        if (*end == '-')
+        {
+            last = strtol(end + 1, &end, 10);
+        }
+
+        if (last < first || last >= CPU_SETSIZE)
+        {
+            return EXIT_FAILURE;
+        }
+
+        for (; first <= last; first++)
+        {
+            CPU_SET(first, cpus);
+        }
+
+        text = *end == ',' ? end + 1 : end;
+    }
+
+    return (*text == '\0' || *text == '\n') && CPU_COUNT(cpus) > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * Print a set of processors in the format of `/sys`, such as `0-3,8`.
+ *
+ * @param cpus A pointer to the set.
+ */
+static void printCpus(const cpu_set_t *cpus)
+{
+    const char *separator;
+    int first;
+    int last;
+
+    separator = "";
+
+    for (first = 0; first < CPU_SETSIZE; first = last + 1)
+    {
+        if (!CPU_ISSET(first, cpus))
+        {
+            last = first;
+            continue;
+        }
+
+        for (last = first; last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, cpus); last++)
+        {
+        }
+
+        if (first == last)
+        {
+            printf("%s%i", separator, first);
+        }
+        else
+        {
+            printf("%s%i-%i", separator, first, last);
+        }
+
+        separator = ",";
+    }
+
+    printf("\n");
+}
+
+/**
+ * Read the processor topology from `/sys/devices/system` the first time it
+ * is needed: the processors of every NUMA node and the groups of processors
+ * sharing a level 3 cache. A machine without NUMA is a single node, and one
+ * without a level 3 cache uses its nodes as cache groups.
+ *
+ * @param topology A pointer to the structure where the topology is stored.
+ */
+static void loadTopology(ttopology *topology)
+{
+    char path[PATH_MAX];
+    char level[CPU_LIST_SIZE];
+    struct dirent *entry;
+    cpu_set_t online;
+    cpu_set_t cpus;
+    DIR *directory;
+    int cpu;
+    int cache;
+
+    if (topology->loaded)
+    {
+        return;
+    }
+
+    topology->loaded = 1;
+    topology->nodes.size = 0;
+    topology->caches.size = 0;
+
+    if (readCpus(ONLINE_CPUS, &online) != EXIT_SUCCESS)
+    {
+        sched_getaffinity(0, sizeof(cpu_set_t), &online);
+    }
+
+    directory = opendir(NODES);
+
+    while (directory != NULL && (entry = readdir(directory)) != NULL)
+    {
+        if (strncmp(entry->d_name, "node", 4) != 0 || entry->d_name[4] < '0' || entry->d_name[4] > '9')
+        {
+            continue;
+        }
+
+        snprintf(path, PATH_MAX, "%s/%s/cpulist", NODES, entry->d_name);
+
+        // Nodes with memory but no processors are skipped
+        if (readCpus(path, &cpus) == EXIT_SUCCESS)
+        {
+            addDomain(&topology->nodes, &cpus);
+        }
+    }
+
+    if (directory != NULL)
+    {
+        closedir(directory);
+    }
+
+    if (topology->nodes.size == 0)
+    {
+        addDomain(&topology->nodes, &online);
+    }
+
+    for (cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        if (!CPU_ISSET(cpu, &online))
+        {
+            continue;
+        }
+
+        for (cache = 0; cache < MAXIMUM_CACHES; cache++)
+        {
+            snprintf(path, PATH_MAX, "%s/cpu%i/cache/index%i/level", CPUS, cpu, cache);
+
+            if (readSystemFile(path, level, CPU_LIST_SIZE) < 0)
+            {
+                break;
+            }
+
+            if (atoi(level) != CACHE_LEVEL)
+            {
+                continue;
+            }
+
+            snprintf(path, PATH_MAX, "%s/cpu%i/cache/index%i/shared_cpu_list", CPUS, cpu, cache);
+
+            if (readCpus(path, &cpus) == EXIT_SUCCESS)
+            {
+                addDomain(&topology->caches, &cpus);
+            }
+
+            break;
+        }
+    }
+
+    if (topology->caches.size == 0)
+    {
+        topology->caches = topology->nodes;
+    }
+}
+
+/**
+ * Add a group of processors to a list of groups, unless it is already in it.
+ *
+ * @param domains A pointer to the list of groups.
+ * @param cpus A pointer to the group.
+ */
+static void addDomain(tdomains *domains, const cpu_set_t *cpus)
+{
+    int index;
+
+    for (index = 0; index < domains->size; index++)
+    {
+        if (CPU_EQUAL(&domains->domains[index], cpus))
+        {
+            return;
+        }
+    }
+
+    if (domains->size < MAXIMUM_DOMAINS)
+    {
+        domains->domains[domains->size++] = *cpus;
+    }
+}
+
+/**
+ * Read a list of processors from a file of `/sys`.
+ *
+ * @param path The path of the file.
+ * @param cpus A pointer to the set where the processors are stored.
+ * @return `EXIT_SUCCESS` if the file holds a list that is not empty,
+ * `EXIT_FAILURE` otherwise.
+ */
+static int readCpus(const char *path, cpu_set_t *cpus)
+{
+    char buffer[CPU_LIST_SIZE];
+
+    if (readSystemFile(path, buffer, CPU_LIST_SIZE) < 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    return parseCpus(buffer, cpus);
+}
+
+/**
+ * Read a small file of `/sys` or `/proc` into a string.
+ *
+ * @param path The path of the file.
+ * @param buffer The buffer where its contents are stored, null terminated.
+ * @param size The size of the buffer.
+ * @return The number of bytes read, or -1 if the file could not be read.
+ */
+static int readSystemFile(const char *path, char *buffer, const int size)
+{
+    int fd;
+    int length;
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    length = read(fd, buffer, size - 1);
+    close(fd);
+
+    if (length < 0)
+    {
+        return -1;
+    }
+
+    buffer[length] = '\0';
+    return length;
+}
+
+/**
+ * Choose the processors of every command of a job.
+ *
+ * Lists of processors are used as given. With `auto`, the whole job runs on
+ * the NUMA node running the fewest jobs placed the same way, so parallel jobs
+ * spread over the nodes. With `l3`, the job gets the group of processors
+ * sharing a level 3 cache that runs the fewest jobs, and each command its own
+ * processor of the group, so adjacent commands pass data through the cache.
+ *
+ * @param placement A pointer to the placement given to `pin`.
+ * @param job The structure representing the job, whose `placement` and
+ * `domain` fields are set.
+ * @param shell A pointer to the structure representing the shell state.
+ * @param cpus The array where the processors of every command are stored.
+ * @param commands The number of commands of the job.
+ */
+static void placeJob(const tplacement *placement, tjob *job, tshell *shell, cpu_set_t *cpus, const int commands)
+{
+    int counts[MAXIMUM_DOMAINS];
+    const tdomains *domains;
+    const cpu_set_t *domain;
+    int command;
+    int index;
+    int first;
+    int cpu;
+
+    job->placement = placement->mode;
+    job->domain = -1;
+
+    if (placement->mode == PIN_CPUS)
+    {
+        for (command = 0; command < commands; command++)
+        {
+            cpus[command] = placement->stages[command < placement->size ? command : placement->size - 1];
+        }
+
+        return;
+    }
+
+    loadTopology(&shell->topology);
+    domains = placement->mode == PIN_AUTO ? &shell->topology.nodes : &shell->topology.caches;
+
+    memset(counts, 0, sizeof(counts));
+
+    for (index = 0; index < shell->jobs.size; index++)
+    {
+        if (&shell->jobs.list[index] != job && shell->jobs.list[index].placement == placement->mode && shell->jobs.list[index].domain >= 0)
+        {
+            counts[shell->jobs.list[index].domain]++;
+        }
+    }
+
+    job->domain = 0;
+
+    for (index = 1; index < domains->size; index++)
+    {
+        if (counts[index] < counts[job->domain])
+        {
+            job->domain = index;
+        }
+    }
+
+    domain = &domains->domains[job->domain];
+
+    for (command = 0; command < commands; command++)
+    {
+        cpus[command] = *domain;
+
+        if (placement->mode == PIN_AUTO)
+        {
+            continue;
+        }
+
+        // Jobs sharing the group start on different processors
+        first = (counts[job->domain] * commands + command) % CPU_COUNT(domain);
+
+        for (cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        {
+            if (CPU_ISSET(cpu, domain) && first-- == 0)
+            {
+                CPU_ZERO(&cpus[command]);
+                CPU_SET(cpu, &cpus[command]);
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * Set the processors every thread of a process may run on.
+ *
+ * @param pid The process identifier.
+ * @param cpus A pointer to the set of processors.
+ * @return `EXIT_SUCCESS` if every thread was moved, `EXIT_FAILURE`
+ * otherwise, with `errno` set.
+ */
+static int pinProcess(const pid_t pid, const cpu_set_t *cpus)
+{
+    char path[PATH_MAX];
+    struct dirent *entry;
+    DIR *directory;
+    int status;
+
+    snprintf(path, PATH_MAX, "/proc/%i/task", pid);
+    directory = opendir(path);
+
+    if (directory == NULL)
+    {
+        return sched_setaffinity(pid, sizeof(cpu_set_t), cpus) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    status = EXIT_SUCCESS;
+
+    while ((entry = readdir(directory)) != NULL)
+    {
+        if (entry->d_name[0] != '.' && sched_setaffinity(atoi(entry->d_name), sizeof(cpu_set_t), cpus) != 0)
+        {
+            status = EXIT_FAILURE;
+        }
+    }
+
+    closedir(directory);
+
+    return status;
+}
+
+/**
+ * Read the policy applied to background jobs from `MSH_BACKGROUND`, a list
+ * of settings separated by commas such as `nice=10,sched=batch,io=idle`.
+ *
+ * `nice` is the minimum niceness of the commands, `sched` their scheduling
+ * policy, `batch` or `idle`, and `io` their I/O scheduling class, `idle` or
+ * `best-effort` optionally followed by `:` and a level from 0 to 7.
+ *
+ * @param variables A pointer to the structure holding the shell variables.
+ * @param policy A pointer to the structure where the policy is stored, which
+ * changes nothing if the variable is not set or not valid.
+ */
+static void readPolicy(tvariables *variables, tpolicy *policy)
+{
+    char text[MAXIMUM_LINE_LENGTH];
+    const char *value;
+    char *setting;
+    char *rest;
+    char *level;
+
+    policy->nice = NO_POLICY;
+    policy->scheduler = NO_POLICY;
+    policy->ioClass = NO_POLICY;
+    policy->ioLevel = 0;
+
+    value = getVariable(variables, BACKGROUND, strlen(BACKGROUND));
+    if (value == NULL)
+    {
+        return;
+    }
+
+    snprintf(text, MAXIMUM_LINE_LENGTH, "%s", value);
+
+    for (setting = strtok_r(text, ",", &rest); setting != NULL; setting = strtok_r(NULL, ",", &rest))
+    {
+        if (strncmp(setting, "nice=", 5) == 0)
+        {
+            policy->nice = atoi(setting + 5);
+        }
+        else if (strcmp(setting, "sched=batch") == 0)
+        {
+            policy->scheduler = SCHED_BATCH;
+        }
+        else if (strcmp(setting, "sched=idle") == 0)
+        {
+            policy->scheduler = SCHED_IDLE;
+        }
+        else if (strcmp(setting, "io=idle") == 0)
+        {
+            policy->ioClass = IOPRIO_CLASS_IDLE;
+        }
+        else if (strncmp(setting, "io=best-effort", 14) == 0)
+        {
+            level = strchr(setting, ':');
+            policy->ioClass = IOPRIO_CLASS_BE;
+            policy->ioLevel = level != NULL ? atoi(level + 1) : DEFAULT_IO_LEVEL;
+        }
+        else
+        {
+            fprintf(stderr, "%s: Error. Invalid setting %s\n", BACKGROUND, setting);
+            policy->nice = NO_POLICY;
+            policy->scheduler = NO_POLICY;
+            policy->ioClass = NO_POLICY;
+            return;
+        }
+    }
+}
+
+/**
+ * Lower the priority of a process following a background policy.
+ *
+ * Called by the children of background jobs and by zygotes before executing
+ * their command, so their descendants inherit it. The niceness is only ever raised, since
+ * unprivileged processes cannot lower it.
+ *
+ * @param policy A pointer to the policy.
+ * @param pid The process identifier, or 0 for the calling process.
+ */
+static void applyPolicy(const tpolicy *policy, const pid_t pid)
+{
+    struct sched_param parameters;
+    int nice;
+
+    if (policy->nice != NO_POLICY)
+    {
+        errno = 0;
+        nice = getpriority(PRIO_PROCESS, pid);
+
+        if (errno == 0 && nice < policy->nice && setpriority(PRIO_PROCESS, pid, policy->nice) != 0)
+        {
+            fprintf(stderr, "%s: Error. nice: %s\n", BACKGROUND, strerror(errno));
+        }
+    }
+
+    if (policy->scheduler != NO_POLICY)
+    {
+        memset(&parameters, 0, sizeof(parameters));
+
+        if (sched_setscheduler(pid, policy->scheduler, &parameters) != 0)
+        {
+            fprintf(stderr, "%s: Error. sched: %s\n", BACKGROUND, strerror(errno));
+        }
+    }
+
+    if (policy->ioClass != NO_POLICY && syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, pid, IOPRIO_VALUE(policy->ioClass, policy->ioLevel)) != 0)
+    {
+        fprintf(stderr, "%s: Error. io: %s\n", BACKGROUND, strerror(errno));
+    }
+}
+
+/**
+ * Queue a command line to be run in background once a slot is free, such as
+ * `submit -p 5 make -j4 > build.log`, instead of starting it at once.
+ *
+ * The rest of the line is kept with its command substitutions done, so they
+ * run once, while its variables, patterns and redirections are only expanded
+ * when it starts. The queue lives in the memory of the shell, so pending
+ * commands are lost if the shell ends before they start. Commands with a higher
+ * priority given by `-p` start first, and equal ones in the order they were
+ * submitted.
+ *
+ * @param buffer The command line with its substitutions done, starting with
+ * `submit`.
+ * @param arguments The arguments of the command, starting with `submit`.
+ * @param shell A pointer to the structure representing the shell state.
+ * @return `EXIT_SUCCESS` if the command was queued, `EXIT_FAILURE`
+ * otherwise.
+ */
+static int mshsubmit(const char *buffer, char **arguments, tshell *shell)
+{
+    tsubmission *submission;
+    char *end;
+    long priority;
+    int first, index, length;
+
+    priority = 0;
+    first = 1;
+
+    if (arguments[first] != NULL && strcmp(arguments[first], "-p") == 0)
+    {
+        priority = arguments[first + 1] != NULL ? strtol(arguments[first + 1], &end, 10) : 0;
+
+        if (arguments[first + 1] == NULL || *end != '\0' || end == arguments[first + 1] || priority < INT_MIN || priority > INT_MAX)
+        {
+            fprintf(stderr, "submit: Error. Invalid priority\n");
+            return EXIT_FAILURE;
+        }
+
+        first += 2;
+    }
+
+    if (arguments[first] == NULL)
+    {
+        fprintf(stderr, "submit: Error. Missing command\n");
+        return EXIT_FAILURE;
+    }
+
+    // Skip the words of `submit` and its options in the line as written
+    for (index = 0; index < first; index++)
+    {
+        buffer += strspn(buffer, " \t");
+        buffer += strcspn(buffer, " \t\n");
+    }
+
+    buffer += strspn(buffer, " \t");
+    length = strlen(buffer);
+
+    // Every submitted command runs in background anyway
+    while (length > 0 && (buffer[length - 1] == '\n' || buffer[length - 1] == ' ' || buffer[length - 1] == '\t' || buffer[length - 1] == '&'))
+    {
+        length--;
+    }
+
+    if (shell->queue.size == shell->queue.capacity)
+    {
+        shell->queue.capacity = shell->queue.capacity > 0 ? shell->queue.capacity * 2 : MAXIMUM_JOB_LIST_SIZE;
+        shell->queue.list = realloc(shell->queue.list, sizeof(tsubmission *) * shell->queue.capacity);
+    }
+
+    submission = calloc(1, sizeof(tsubmission));
+    submission->number = ++shell->queue.next;
+    submission->priority = priority;
+    submission->state = SUBMISSION_PENDING;
+    submission->command = strndup(buffer, length);
+    clock_gettime(CLOCK_MONOTONIC, &submission->submitted);
+
+    shell->queue.list[shell->queue.size++] = submission;
+
+    schedule(shell);
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * List the commands given to `submit` with their state, priority, time
+ * spent waiting for a slot and time spent running, or with `-c` forget the
+ * ones that finished.
+ *
+ * @param arguments The arguments of the command, starting with `queue`.
+ * @param queue A pointer to the structure representing the queue.
+ * @return `EXIT_SUCCESS`, or `EXIT_FAILURE` if the option is not valid.
+ */
+static int mshqueue(char **arguments, tqueue *queue)
+{
+    static const char *const states[] = {"Pending", "Running", "Done"};
+
+    tsubmission *submission;
+    long waited, ran;
+    int index, kept;
+
+    if (arguments[1] != NULL && strcmp(arguments[1], "-c") != 0)
+    {
+        fprintf(stderr, "queue: Error. Invalid option %s\n", arguments[1]);
+        return EXIT_FAILURE;
+    }
+
+    if (arguments[1] != NULL)
+    {
+        kept = 0;
+
+        for (index = 0; index < queue->size; index++)
+        {
+            if (queue->list[index]->state == SUBMISSION_DONE)
+            {
+                free(queue->list[index]->command);
+                free(queue->list[index]);
+                continue;
+            }
+
+            queue->list[kept++] = queue->list[index];
+        }
+
+        queue->size = kept;
+        return EXIT_SUCCESS;
+    }
+
+    for (index = 0; index < queue->size; index++)
+    {
+        submission = queue->list[index];
+
+        waited = interval(&submission->submitted, submission->state == SUBMISSION_PENDING ? NULL : &submission->started);
+        ran = submission->state == SUBMISSION_PENDING ? 0 : interval(&submission->started, submission->state == SUBMISSION_RUNNING ? NULL : &submission->ended);
+
+        printf("[%i] %s", submission->number, states[submission->state]);
+
+        if (submission->state == SUBMISSION_DONE && submission->status != EXIT_SUCCESS)
+        {
+            printf(" (%i)", submission->status);
+        }
+
+        printf("\tpriority %i\twaited %li.%03li s\tran %li.%03li s\t%s\n", submission->priority, waited / 1000, waited % 1000, ran / 1000, ran % 1000, submission->command);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Start pending submissions while there are free slots, the highest
+ * priority first.
+ *
+ * Called whenever a command is submitted and whenever finished jobs are
+ * reaped. A slot is never taken while the list of jobs is full, nor once
+ * `exit` ran.
+ *
+ * @param shell A pointer to the structure representing the shell state.
+ */
+static void schedule(tshell *shell)
+{
+    tsubmission *submission;
+    int slots, index;
+
+    slots = querySlots(shell);
+
+    while (shell->queue.running < slots && shell->jobs.size < MAXIMUM_JOB_LIST_SIZE - 1 && !shell->exited)
+    {
+        submission = NULL;
+
+        for (index = 0; index < shell->queue.size; index++)
+        {
+            if (shell->queue.list[index]->state == SUBMISSION_PENDING && (submission == NULL || shell->queue.list[index]->priority > submission->priority))
+            {
+                submission = shell->queue.list[index];
+            }
+        }
+
+        if (submission == NULL)
+        {
+            return;
+        }
+
+        submission->state = SUBMISSION_RUNNING;
+        clock_gettime(CLOCK_MONOTONIC, &submission->started);
+        shell->queue.running++;
+
+        // Internal commands finish at once, calling back before returning
+        if (msh_start(shell, submission->command, finishSubmission, submission) < 0)
+        {
+            finishSubmission(shell, 0, NULL, submission);
+        }
+    }
+}
+
+/**
+ * Get the number of submitted commands run at once: the value of
+ * `MSH_QUEUE_SLOTS` if it is a positive number, or otherwise the number of
+ * online processors minus the ones kept busy by other processes according
+ * to the load average, and at least one.
+ *
+ * @param shell A pointer to the structure representing the shell state.
+ * @return The number of slots.
+ */
+static int querySlots(tshell *shell)
+{
+    const char *value;
+    double load;
+    long processors;
+    int slots, busy;
+
+    value = getVariable(&shell->variables, QUEUE_SLOTS, strlen(QUEUE_SLOTS));
+
+    if (value != NULL && atoi(value) > 0)
+    {
+        return atoi(value);
+    }
+
+    processors = sysconf(_SC_NPROCESSORS_ONLN);
+    processors = processors > 0 ? processors : 1;
+
+    // The running submissions are part of the load themselves
+    busy = getloadavg(&load, 1) == 1 ? (int)(load + 0.5) - shell->queue.running : 0;
+    slots = processors - (busy > 0 ? busy : 0);
+
+    return slots > 0 ? slots : 1;
+}
+
+/**
+ * Record the outcome of a submitted command, freeing its slot.
+ *
+ * @param shell A pointer to the structure representing the shell state.
+ * @param job The number the job had when it finished.
+ * @param result The outcome of the command, or NULL if it could not start.
+ * @param data A pointer to the submission.
+ */
+static void finishSubmission(msh_context *shell, int job, const msh_result *result, void *data)
+{
+    tsubmission *submission;
+
+    (void)job;
+
+    submission = data;
+    submission->state = SUBMISSION_DONE;
+    submission->status = result != NULL ? result->status : EXIT_FAILURE;
+    clock_gettime(CLOCK_MONOTONIC, &submission->ended);
+
+    shell->queue.running--;
+}
+
+/**
+ * Get the number of milliseconds between two moments.
+ *
+ * @param start The first moment.
+ * @param end The second moment, or NULL for the current one.
+ * @return The number of milliseconds.
+ */
+static long interval(const struct timespec *start, const struct timespec *end)
+{
+    if (end == NULL)
+    {
+        return milliseconds(start);
+    }
+
+    return (end->tv_sec - start->tv_sec) * 1000 + (end->tv_nsec - start->tv_nsec) / 1000000;
+}
+
+/**
+ * Change the niceness of running jobs or processes.
+ *
+ * Handles `renice priority %n...`, which applies to the whole process group
+ * of every job, so descendants are included, and also accepts process
+ * identifiers.
+ *
+ * @param arguments The arguments of the command, starting with `renice`.
+ * @param jobs A pointer to the structure representing the list of jobs.
+ * @return `EXIT_SUCCESS` if every job or process was changed,
+ * `EXIT_FAILURE` otherwise.
+ */
+static int mshrenice(char **arguments, tjobs *jobs)
+{
+    char *end;
+    long priority;
+    int mappedJob;
+    int index;
+    int status;
+
+    if (arguments[PRIORITY] == NULL || arguments[PRIORITY + 1] == NULL)
+    {
+        fprintf(stderr, "renice: Error. Usage: renice priority %%n...\n");
+        return EXIT_FAILURE;
+    }
+
+    priority = strtol(arguments[PRIORITY], &end, 10);
+
+    if (*end != '\0')
+    {
+        fprintf(stderr, "%s: Error. Invalid priority\n", arguments[PRIORITY]);
+        return EXIT_FAILURE;
+    }
+
+    status = EXIT_SUCCESS;
+
+    for (index = PRIORITY + 1; arguments[index] != NULL; index++)
+    {
+        if (arguments[index][0] != JOB_PREFIX)
+        {
+            if (setpriority(PRIO_PROCESS, atoi(arguments[index]), priority) != 0)
+            {
+                fprintf(stderr, "%s: Error. %s\n", arguments[index], strerror(errno));
+                status = EXIT_FAILURE;
+            }
+
+            continue;
+        }
+
+        mappedJob = jobNumber(arguments[index], jobs);
+
+        if (mappedJob < 0)
+        {
+            fprintf(stderr, "%s: Error. No such job\n", arguments[index]);
+            status = EXIT_FAILURE;
+            continue;
+        }
+
+        if (setpriority(PRIO_PGRP, jobs->list[mappedJob].pgid, priority) != 0)
+        {
+            fprintf(stderr, "%s: Error. %s\n", arguments[index], strerror(errno));
+            status = EXIT_FAILURE;
+        }
+    }
+
+    return status;
+}
+
+/**
+ * Enable job control if the standard input is a terminal.
+ *
+ * The shell waits until it is in the foreground, moves to its own process
+ * group and takes the terminal. It also ignores the job control signals, so
+ * `Ctrl+Z` only stops the foreground job and the shell can hand the terminal
+ * over while it is not in the foreground.
+ *
+ * @param shell A pointer to the structure representing the shell state.
+ * @return 1 if job control was enabled, 0 otherwise.
+ */
+int msh_enable_job_control(msh_context *shell)
+{
+    shell->interactive = isatty(TERMINAL);
+
+    if (!shell->interactive)
+    {
+        return 0;
+    }
+
+    while (tcgetpgrp(TERMINAL) != (shell->pgid = getpgrp()))
+    {
+        kill(-shell->pgid, SIGTTIN);
+    }
+
+    signal(SIGTSTP, SIG_IGN);
+    signal(SIGTTIN, SIG_IGN);
+    signal(SIGTTOU, SIG_IGN);
+
+    setpgid(0, 0);
+    shell->pgid = getpgrp();
+    tcsetpgrp(TERMINAL, shell->pgid);
+
+    return 1;
+}
+
+/**
+ * Set the signal dispositions of a child process before it executes a
+ * command.
+ *
+ * The job control signals ignored by the shell are restored, along with
+ * `SIGINT` and `SIGQUIT`, whose handlers installed by the program embedding
+ * the shell are only reset by `execve()`. Children that never execute a
+ * program, such as the drivers of `parallel`, `|||`, `|{ }` and batches,
+ * must be stopped by `Ctrl+C` like any command.
+ */
+static void resetSignals()
+{
+    signal(SIGINT, SIG_DFL);
+    signal(SIGQUIT, SIG_DFL);
+    signal(SIGTSTP, SIG_DFL);
+    signal(SIGTTIN, SIG_DFL);
+    signal(SIGTTOU, SIG_DFL);
+}
+
+/**
+ * Expand the words of a command line, replacing variable references by their
+ * values and every word containing glob metacharacters by the sorted list of
+ * paths it matches.
+ *
+ * Words that expand to nothing are removed and words that do not match any
+ * path are kept unchanged, like in `sh`. The files of the redirections only
+ * have their variables expanded, such as `> $OUT`. The
+ * returned command line owns all of its memory and must be released with
+ * `release()`, so it stays valid even if the parser reuses its own storage.
+ *
+ * @param line A pointer to a `tline` structure returned by `tokenize()`.
+ * @param variables A pointer to the structure holding the shell variables.
+ * @return A new `tline` structure with the expanded arguments.
+ */
+static tline *expand(const tline *line, tvariables *variables)
+{
+    tline *expandedLine;
+    tcommand *command;
+    tmatches matches;
+    const char *threadsValue;
+    char *word;
+    int threads;
+    int c, a, m;
+
+    threadsValue = getVariable(variables, GLOB_THREADS, strlen(GLOB_THREADS));
+    threads = threadsValue != NULL ? atoi(threadsValue) : DEFAULT_GLOB_THREADS;
+
+    expandedLine = malloc(sizeof(tline));
+    *expandedLine = *line;
+    expandedLine->commands = malloc(sizeof(tcommand) * line->ncommands);
+    // Redirections name a single file, so only their variables are expanded
+    expandedLine->redirect_input = line->redirect_input != NULL ? expandVariables(line->redirect_input, variables) : NULL;
+    expandedLine->redirect_output = line->redirect_output != NULL ? expandVariables(line->redirect_output, variables) : NULL;
+    expandedLine->redirect_error = line->redirect_error != NULL ? expandVariables(line->redirect_error, variables) : NULL;
+
+    for (c = 0; c < line->ncommands; c++)
+    {
+        command = &expandedLine->commands[c];
+
+        matches.list = malloc(sizeof(char *) * INITIAL_CAPACITY);
+        matches.size = 0;
+        matches.capacity = INITIAL_CAPACITY;
+
+        for (a = 0; a < line->commands[c].argc; a++)
+        {
+            m = matches.size;
+            word = expandVariables(line->commands[c].argv[a], variables);
+
+            if (word[0] != '\0' && wildcard(word))
+            {
+                expandGlob(word, &matches, threads);
+            }
+
+            // Unmatched patterns are passed through literally
+            if (word[0] != '\0' && m == matches.size)
+            {
+                addMatch(&matches, word, strlen(word), NULL);
+            }
+
+            free(word);
+        }
+
+        addMatch(&matches, NULL, 0, NULL);
+
+        command->argc = matches.size - 1;
+        command->argv = matches.list;
+        command->filename = line->commands[c].filename != NULL ? strdup(line->commands[c].filename) : NULL;
+    }
+
+    return expandedLine;
+}
+
+/**
+ * Free a command line returned by `expand()`.
+ *
+ * @param line A pointer to the `tline` structure to be freed.
+ */
+static void release(tline *line)
+{
+    int c, a;
+
+    for (c = 0; c < line->ncommands; c++)
+    {
+        for (a = 0; a < line->commands[c].argc; a++)
+        {
+            free(line->commands[c].argv[a]);
+        }
+
+        free(line->commands[c].argv);
+        free(line->commands[c].filename);
+    }
+
+    free(line->commands);
+    free(line->redirect_input);
+    free(line->redirect_output);
+    free(line->redirect_error);
+    free(line);
+}
+
+/**
+ * Check if a word contains glob metacharacters.
+ *
+ * @param word The word to be checked.
+ * @return 1 if the word contains `*`, `?`, `[` or an escaped character, 0
+ * otherwise.
+ */
+static int wildcard(const char *word)
+{
+    return strpbrk(word, "*?[\\") != NULL;
+}
+
+/**
+ * Check if a file name matches a single glob pattern component.
+ *
+ * Supports `*` (any sequence of characters), `?` (any single character),
+ * bracket expressions such as `[a-z]`, `[!0-9]` or `[^.]`, and `\` to match
+ * the following character literally. A leading `.` in the name must be
+ * matched explicitly by the pattern.
+ *
+ * @param pattern The pattern component, which must not contain `/`.
+ * @param name The file name to be matched.
+ * @return 1 if the name matches the pattern, 0 otherwise.
+ */
+static int match(const char *pattern, const char *name)
+{
+    const char *starPattern, *starName;
+    const char *bracket;
+    int negated, matched;
+
+    if (name[0] == '.' && pattern[0] != '.')
+    {
+        return 0;
+    }
+
+    starPattern = NULL;
+    starName = NULL;
+
+    while (*name != '\0')
+    {
+        if (*pattern == '*')
+        {
+            // Remember the star to backtrack when the rest does not match
+            starPattern = ++pattern;
+            starName = name;
+            continue;
+        }
+
+        // A `[` ending the pattern is a literal
+        if (*pattern == '[' && pattern[1] != '\0' && (bracket = strchr(pattern + 2, ']')) != NULL)
+        {
+            pattern++;
+            negated = *pattern == '!' || *pattern == '^';
+            pattern += negated;
+            matched = 0;
+
+            // A closing bracket right after the opening one is a literal
+            do
+            {
+                if (pattern[1] == '-' && pattern + 2 < bracket)
+                {
+                    matched |= (unsigned char)*name >= (unsigned char)pattern[0] && (unsigned char)*name <= (unsigned char)pattern[2];
+                    pattern += 3;
+                }
+                else
+                {
+                    matched |= *name == *pattern;
+                    pattern++;
+                }
+            } while (pattern < bracket);
+
+            if (matched != negated)
+            {
+                pattern = bracket + 1;
+                name++;
+                continue;
+            }
+        }
+        else if (*pattern == '?' || (*pattern == '\\' && pattern[1] == *name) || (*pattern != '\\' && *pattern == *name))
+        {
+            pattern += *pattern == '\\' ? 2 : 1;
+            name++;
+            continue;
+        }
+
+        if (starPattern == NULL)
+        {
+            return 0;
+        }
+
+        pattern = starPattern;
+        name = ++starName;
+    }
+
+    while (*pattern == '*')
+    {
+        pattern++;
+    }
+
+    return *pattern == '\0';
+}
+
+/**
+ * Append to `matches` every path matching a glob pattern, sorted in byte
+ * order and without duplicates.
+ *
+ * The pattern is split into `/` separated components. Components without
+ * metacharacters are resolved directly, the rest are matched against
+ * directory entries read with `getdents64`, and `**` matches any number of
+ * nested directories, without following symbolic links.
+ *
+ * @param pattern The glob pattern to be expanded.
+ * @param matches The list where the matched paths are appended.
+ * @param threads The maximum number of threads used to walk `**` patterns.
+ */
+static void expandGlob(const char *pattern, tmatches *matches, const int threads)
+{
+    char path[PATH_MAX];
+    char *copy, *component, *state;
+    char **components;
+    char **auxiliar;
+    unsigned char *keys;
+    int count, length, directoriesOnly;
+    int dirfd;
+    int first, index, unique;
+
+    copy = strdup(pattern);
+    components = malloc(sizeof(char *) * (strlen(pattern) / 2 + 2));
+    count = 0;
+
+    for (component = strtok_r(copy, "/", &state); component != NULL; component = strtok_r(NULL, "/", &state))
+    {
+        components[count++] = component;
+    }
+
+    length = 0;
+    if (pattern[0] == '/')
+    {
+        path[length++] = '/';
+    }
+    path[length] = '\0';
+
+    directoriesOnly = pattern[strlen(pattern) - 1] == '/';
+
+    dirfd = open(length > 0 ? "/" : ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    first = matches->size;
+
+    if (dirfd >= 0 && count > 0)
+    {
+        walk(dirfd, path, length, components, count, 0, directoriesOnly, threads, matches);
+        close(dirfd);
+    }
+
+    if (matches->size - first > 1)
+    {
+        auxiliar = malloc(sizeof(char *) * (matches->size - first));
+        keys = malloc(matches->size - first);
+
+        radixSort(matches->list + first, auxiliar, keys, matches->size - first, 0);
+
+        free(auxiliar);
+        free(keys);
+
+        // Duplicates can only come from patterns like `**/**`
+        unique = first + 1;
+        for (index = first + 1; index < matches->size; index++)
+        {
+            if (strcmp(matches->list[index], matches->list[unique - 1]) == 0)
+            {
+                free(matches->list[index]);
+            }
+            else
+            {
+                matches->list[unique++] = matches->list[index];
+            }
+        }
+        matches->size = unique;
+    }
+
+    free(components);
+    free(copy);
+}
+
+/**
+ * Match the pattern components starting at `index` against the directory
+ * `dirfd`, recursing into the subdirectories that match.
+ *
+ * @param dirfd An open file descriptor of the directory being walked.
+ * @param path A buffer of `PATH_MAX` bytes holding the path of `dirfd`.
+ * @param length The length of the path held in `path`.
+ * @param components The pattern components.
+ * @param count The number of pattern components.
+ * @param index The index of the component matched against this directory.
+ * @param directoriesOnly Flag indicating whether only directories match.
+ * @param threads The maximum number of threads used to walk `**` patterns.
+ * @param matches The list where the matched paths are appended.
+ */
+static void walk(int dirfd, char *path, int length, char **components, int count, int index, int directoriesOnly, int threads, tmatches *matches)
+{
+    char *buffer;
+    char *component;
+    char **directories;
+    struct linux_dirent64 *entry;
+    struct stat status;
+    long bytes, offset;
+    int last, globstar, size, capacity;
+
+    if (index == count)
+    {
+        // The directory the walk started from is never a match
+        if (length > 0)
+        {
+            addMatch(matches, path, length, NULL);
+        }
+        return;
+    }
+
+    component = components[index];
+    last = index == count - 1 && !directoriesOnly;
+    globstar = strcmp(component, "**") == 0;
+
+    if (!globstar && !wildcard(component))
+    {
+        // Literal components are resolved without reading the directory
+        if (last)
+        {
+            if (fstatat(dirfd, component, &status, AT_SYMLINK_NOFOLLOW) == 0)
+            {
+                addMatch(matches, path, length, component);
+            }
+        }
+        else
+        {
+            descend(dirfd, component, path, length, components, count, index + 1, directoriesOnly, threads, matches);
+        }
+        return;
+    }
+
+    if (globstar && !last)
+    {
+        // `**` also matches zero directories
+        walk(dirfd, path, length, components, count, index + 1, directoriesOnly, threads, matches);
+    }
+
+    buffer = malloc(DIRECTORY_BUFFER_SIZE);
+    directories = NULL;
+    size = 0;
+    capacity = 0;
+
+    // The directory may have been read already while matching zero directories
+    lseek(dirfd, 0, SEEK_SET);
+
+    while ((bytes = syscall(SYS_getdents64, dirfd, buffer, DIRECTORY_BUFFER_SIZE)) > 0)
+    {
+        for (offset = 0; offset < bytes; offset += entry->d_reclen)
+        {
+            entry = (struct linux_dirent64 *)(buffer + offset);
+
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+            {
+                continue;
+            }
+
+            if (globstar ? entry->d_name[0] == '.' : !match(component, entry->d_name))
+            {
+                continue;
+            }
+
+            if (last)
+            {
+                addMatch(matches, path, length, entry->d_name);
+
+                if (!globstar)
+                {
+                    continue;
+                }
+            }
+
+            if (!directory(dirfd, entry->d_name, entry->d_type, !globstar))
+            {
+                continue;
+            }
+
+            if (globstar && threads > 1)
+            {
+                // Defer the subdirectory to be shared among the workers
+                if (size == capacity)
+                {
+                    capacity = capacity == 0 ? INITIAL_CAPACITY : capacity * 2;
+                    directories = realloc(directories, sizeof(char *) * capacity);
+                }
+                directories[size++] = strdup(entry->d_name);
+            }
+            else
+            {
+                descend(dirfd, entry->d_name, path, length, components, count, globstar ? index : index + 1, directoriesOnly, globstar ? 1 : threads, matches);
+            }
+        }
+    }
+
+    free(buffer);
+
+    if (size > 0)
+    {
+        walkParallel(dirfd, path, length, components, count, index, directoriesOnly, directories, size, threads, matches);
+    }
+
+    free(directories);
+}
+
+/**
+ * Open a subdirectory and continue the walk inside it.
+ *
+ * @param dirfd An open file descriptor of the parent directory.
+ * @param name The name of the subdirectory, relative to `dirfd`.
+ * @param path A buffer of `PATH_MAX` bytes holding the path of `dirfd`.
+ * @param length The length of the path held in `path`.
+ * @param components The pattern components.
+ * @param count The number of pattern components.
+ * @param index The index of the component matched against the subdirectory.
+ * @param directoriesOnly Flag indicating whether only directories match.
+ * @param threads The maximum number of threads used to walk `**` patterns.
+ * @param matches The list where the matched paths are appended.
+ */
+static void descend(int dirfd, const char *name, char *path, int length, char **components, int count, int index, int directoriesOnly, int threads, tmatches *matches)
+{
+    int subdirfd;
+    int nameLength;
+
+    nameLength = strlen(name);
+
+    if (length + nameLength + 2 > PATH_MAX)
+    {
+        return;
+    }
+
+    subdirfd = openat(dirfd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    if (subdirfd < 0)
+    {
+        return;
+    }
+
+    memcpy(path + length, name, nameLength);
+    path[length + nameLength] = '/';
+    path[length + nameLength + 1] = '\0';
+
+    walk(subdirfd, path, length + nameLength + 1, components, count, index, directoriesOnly, threads, matches);
+
+    path[length] = '\0';
+    close(subdirfd);
+}
+
+/**
+ * Thread routine walking the subdirectories shared by a parallel `**` walk.
+ *
+ * Subdirectories are taken one at a time from the shared list, so threads
+ * that finish small subtrees early keep picking up the remaining ones.
+ *
+ * @param argument A pointer to the `tglobworker` structure of the thread.
+ * @return Always NULL.
+ */
+static void *globWorker(void *argument)
+{
+    tglobworker *worker;
+    char path[PATH_MAX];
+    int index;
+
+    worker = argument;
+    memcpy(path, worker->path, worker->length + 1);
+
+    while ((index = __atomic_fetch_add(worker->next, 1, __ATOMIC_RELAXED)) < worker->size)
+    {
+        descend(worker->dirfd, worker->directories[index], path, worker->length, worker->components, worker->count, worker->index, worker->directoriesOnly, 1, &worker->matches);
+    }
+
+    return NULL;
+}
+
+/**
+ * Walk a list of subdirectories of a `**` component using several threads,
+ * appending the paths found by every thread to `matches`.
+ *
+ * @param dirfd An open file descriptor of the parent directory.
+ * @param path A buffer holding the path of `dirfd`.
+ * @param length The length of the path held in `path`.
+ * @param components The pattern components.
+ * @param count The number of pattern components.
+ * @param index The index of the `**` component.
+ * @param directoriesOnly Flag indicating whether only directories match.
+ * @param directories Heap allocated subdirectory names, freed by this
+ * function.
+ * @param size The number of subdirectory names.
+ * @param threads The maximum number of threads to be used.
+ * @param matches The list where the matched paths are appended.
+ */
+static void walkParallel(int dirfd, char *path, int length, char **components, int count, int index, int directoriesOnly, char **directories, int size, int threads, tmatches *matches)
+{
+    pthread_t identifiers[MAXIMUM_GLOB_THREADS];
+    tglobworker workers[MAXIMUM_GLOB_THREADS];
+    int next, started;
+    int w, m;
+
+    next = 0;
+    threads = threads > size ? size : threads;
+    threads = threads > MAXIMUM_GLOB_THREADS ? MAXIMUM_GLOB_THREADS : threads;
+
+    for (w = 0; w < threads; w++)
+    {
+        workers[w].dirfd = dirfd;
+        workers[w].path = path;
+        workers[w].length = length;
+        workers[w].components = components;
+        workers[w].count = count;
+        workers[w].index = index;
+        workers[w].directoriesOnly = directoriesOnly;
+        workers[w].directories = directories;
+        workers[w].size = size;
+        workers[w].next = &next;
+        workers[w].matches.list = malloc(sizeof(char *) * INITIAL_CAPACITY);
+        workers[w].matches.size = 0;
+        workers[w].matches.capacity = INITIAL_CAPACITY;
+    }
+
+    // The calling thread is the first worker
+    for (started = 1; started < threads; started++)
+    {
+        if (pthread_create(&identifiers[started], NULL, globWorker, &workers[started]) != 0)
+        {
+            break;
+        }
+    }
+
+    globWorker(&workers[0]);
+
+    for (w = 0; w < threads; w++)
+    {
+        if (w > 0 && w < started)
+        {
+            pthread_join(identifiers[w], NULL);
+        }
+
+        for (m = 0; m < workers[w].matches.size; m++)
+        {
+            addMatch(matches, NULL, 0, NULL);
+            matches->list[matches->size - 1] = workers[w].matches.list[m];
+        }
+
+        free(workers[w].matches.list);
+    }
+
+    for (w = 0; w < size; w++)
+    {
+        free(directories[w]);
+    }
+}
+
+/**
+ * Check if a directory entry is a directory, avoiding a `stat` call when the
+ * file system reports the entry type.
+ *
+ * @param dirfd An open file descriptor of the directory holding the entry.
+ * @param name The name of the entry.
+ * @param type The `d_type` reported by `getdents64`.
+ * @param follow Flag indicating whether symbolic links are followed.
+ * @return 1 if the entry is a directory, 0 otherwise.
+ */
+static int directory(int dirfd, const char *name, unsigned char type, int follow)
+{
+    struct stat status;
+
+    if (type == DT_DIR)
+    {
+        return 1;
+    }
+
+    if (type != DT_UNKNOWN && (type != DT_LNK || !follow))
+    {
+        return 0;
+    }
+
+    if (fstatat(dirfd, name, &status, follow ? 0 : AT_SYMLINK_NOFOLLOW) != 0)
+    {
+        return 0;
+    }
+
+    return S_ISDIR(status.st_mode);
+}
+
+/**
+ * Append a copy of a path, optionally followed by a file name, to a list of
+ * matches, growing it if needed. A NULL path appends an empty slot for the
+ * caller to fill.
+ *
+ * @param matches The list where the path is appended.
+ * @param path The path to be appended, or NULL.
+ * @param length The length of the path.
+ * @param name The file name appended to the path, or NULL.
+ */
+static void addMatch(tmatches *matches, const char *path, int length, const char *name)
+{
+    int size;
+
+    if (matches->size == matches->capacity)
+    {
+        matches->capacity *= 2;
+        matches->list = realloc(matches->list, sizeof(char *) * matches->capacity);
+    }
+
+    if (path == NULL)
+    {
+        matches->list[matches->size++] = NULL;
+        return;
+    }
+
+    size = name != NULL ? strlen(name) : 0;
+
+    matches->list[matches->size] = malloc(length + size + 1);
+    memcpy(matches->list[matches->size], path, length);
+
+    if (name != NULL)
+    {
+        memcpy(matches->list[matches->size] + length, name, size);
+    }
+
+    matches->list[matches->size][length + size] = '\0';
+    matches->size++;
+}
+
+/**
+ * Sort strings in byte order using a most significant digit radix sort.
+ *
+ * The byte at `depth` of every string is copied into `keys` once per pass,
+ * so the counting and distribution loops scan a contiguous array instead of
+ * dereferencing every string twice. Small buckets fall back to insertion
+ * sort.
+ *
+ * @param list The strings to be sorted, which share their first `depth`
+ * bytes.
+ * @param auxiliar A scratch array with room for `size` strings.
+ * @param keys A scratch array with room for `size` bytes.
+ * @param size The number of strings.
+ * @param depth The index of the byte used to distribute the strings.
+ */
+static void radixSort(char **list, char **auxiliar, unsigned char *keys, int size, int depth)
+{
+    int counts[UCHAR_MAX + 1];
+    int offsets[UCHAR_MAX + 1];
+    char *current;
+    int index, previous, bucket;
+
+    if (size < RADIX_SORT_THRESHOLD)
+    {
+        for (index = 1; index < size; index++)
+        {
+            current = list[index];
+
+            for (previous = index - 1; previous >= 0 && strcmp(list[previous] + depth, current + depth) > 0; previous--)
+            {
+                list[previous + 1] = list[previous];
+            }
+
+            list[previous + 1] = current;
+        }
+        return;
+    }
+
+    memset(counts, 0, sizeof(counts));
+
+    for (index = 0; index < size; index++)
+    {
+        keys[index] = list[index][depth];
+        counts[keys[index]]++;
+    }
+
+    offsets[0] = 0;
+    for (bucket = 1; bucket <= UCHAR_MAX; bucket++)
+    {
+        offsets[bucket] = offsets[bucket - 1] + counts[bucket - 1];
+    }
+
+    for (index = 0; index < size; index++)
+    {
+        auxiliar[offsets[keys[index]]++] = list[index];
+    }
+
+    memcpy(list, auxiliar, sizeof(char *) * size);
+
+    // Strings ending at this depth are already in place in the first bucket
+    for (bucket = 1; bucket <= UCHAR_MAX; bucket++)
+    {
+        if (counts[bucket] > 1)
+        {
+            index = offsets[bucket] - counts[bucket];
+            radixSort(list + index, auxiliar + index, keys + index, counts[bucket], depth + 1);
+        }
+    }
+}
+
+/**
+ * Initialize the shell variables with the variables of an environment, all
+ * of them exported.
+ *
+ * @param variables A pointer to the structure to be initialized.
+ * @param environment The `NULL` terminated environment of the shell.
+ */
+static void initializeVariables(tvariables *variables, char **environment)
+{
+    char *separator;
+    int index;
+
+    variables->table = calloc(INITIAL_VARIABLES_CAPACITY, sizeof(tvariable));
+    variables->capacity = INITIAL_VARIABLES_CAPACITY;
+    variables->size = 0;
+    variables->deleted = 0;
+    variables->environment = NULL;
+    variables->environmentCapacity = 0;
+    variables->changed = 1;
+
+    for (index = 0; environment[index] != NULL; index++)
+    {
+        separator = strchr(environment[index], ASSIGNMENT);
+
+        if (separator != NULL)
+        {
+            setVariable(variables, environment[index], separator - environment[index], separator + 1, 1);
+        }
+    }
+}
+
+/**
+ * Compute the FNV-1a hash of a variable name.
+ *
+ * @param name The name, which does not need to be null terminated.
+ * @param length The length of the name.
+ * @return The hash of the name.
+ */
+static unsigned int hash(const char *name, int length)
+{
+    unsigned int value;
+    int index;
+
+    value = FNV_OFFSET;
+
+    for (index = 0; index < length; index++)
+    {
+        value ^= (unsigned char)name[index];
+        value *= FNV_PRIME;
+    }
+
+    return value;
+}
+
+/**
+ * Find the slot of a variable using linear probing.
+ *
+ * @param variables A pointer to the structure holding the shell variables.
+ * @param name The name of the variable, which does not need to be null
+ * terminated.
+ * @param length The length of the name.
+ * @param nameHash The hash of the name.
+ * @return The slot holding the variable if it is set, or the first free slot
+ * of its probe sequence otherwise.
+ */
+static tvariable *lookup(tvariables *variables, const char *name, int length, unsigned int nameHash)
+{
+    tvariable *slot, *free;
+    unsigned int mask, index;
+
+    mask = variables->capacity - 1;
+    free = NULL;
+
+    for (index = nameHash & mask;; index = (index + 1) & mask)
+    {
+        slot = &variables->table[index];
+
+        if (slot->entry == NULL)
+        {
+            if (!slot->deleted)
+            {
+                return free != NULL ? free : slot;
+            }
+
+            // Reuse the first deleted slot if the name is not found
+            if (free == NULL)
+            {
+                free = slot;
+            }
+        }
+        else if (slot->hash == nameHash && slot->nameLength == length && memcmp(slot->entry, name, length) == 0)
+        {
+            return slot;
+        }
+    }
+}
+
+/**
+ * Get the value of a shell variable.
+ *
+ * @param variables A pointer to the structure holding the shell variables.
+ * @param name The name of the variable, which does not need to be null
+ * terminated.
+ * @param length The length of the name.
+ * @return The value of the variable, or NULL if it is not set.
+ */
+static const char *getVariable(tvariables *variables, const char *name, int length)
+{
+    tvariable *slot;
+
+    slot = lookup(variables, name, length, hash(name, length));
+
+    if (slot->entry == NULL)
+    {
+        return NULL;
+    }
+
+    return slot->entry + slot->nameLength + 1;
+}
+
+/**
+ * Set the value of a shell variable, creating it if needed.
+ *
+ * The previous `NAME=value` entry is replaced rather than modified, so the
+ * environment built by `exportedEnvironment()` is never written to and only
+ * needs to be rebuilt when an exported variable changes.
+ *
+ * @param variables A pointer to the structure holding the shell variables.
+ * @param name The name of the variable, which does not need to be null
+ * terminated.
+ * @param length The length of the name.
+ * @param value The new value of the variable, or NULL to keep the current
+ * value.
+ * @param exported 1 to export the variable, 0 to stop exporting it, or
+ * `KEEP_EXPORT` to leave it as it is.
+ */
+static void setVariable(tvariables *variables, const char *name, int length, const char *value, int exported)
+{
+    tvariable *slot;
+    unsigned int nameHash;
+    int valueLength;
+    char *entry;
+
+    if ((variables->size + variables->deleted + 1) * 4 > variables->capacity * 3)
+    {
+        grow(variables);
+    }
+
+    nameHash = hash(name, length);
+    slot = lookup(variables, name, length, nameHash);
+
+    if (slot->entry == NULL)
+    {
+        variables->deleted -= slot->deleted;
+        variables->size++;
+
+        slot->nameLength = length;
+        slot->hash = nameHash;
+        slot->exported = 0;
+        slot->deleted = 0;
+
+        value = value != NULL ? value : "";
+    }
+
+    if (value != NULL)
+    {
+        valueLength = strlen(value);
+
+        entry = malloc(length + valueLength + 2);
+        memcpy(entry, name, length);
+        entry[length] = ASSIGNMENT;
+        memcpy(entry + length + 1, value, valueLength + 1);
+
+        free(slot->entry);
+        slot->entry = entry;
+
+        variables->changed |= slot->exported;
+    }
+
+    if (exported != KEEP_EXPORT && exported != slot->exported)
+    {
+        slot->exported = exported;
+        variables->changed = 1;
+    }
+}
+
+/**
+ * Remove a shell variable.
+ *
+ * @param variables A pointer to the structure holding the shell variables.
+ * @param name The name of the variable, which does not need to be null
+ * terminated.
+ * @param length The length of the name.
+ */
+static void unsetVariable(tvariables *variables, const char *name, int length)
+{
+    tvariable *slot;
+
+    slot = lookup(variables, name, length, hash(name, length));
+
+    if (slot->entry == NULL)
+    {
+        return;
+    }
+
+    variables->changed |= slot->exported;
+
+    free(slot->entry);
+    slot->entry = NULL;
+    slot->deleted = 1;
+
+    variables->size--;
+    variables->deleted++;
+}
+
+/**
+ * Rehash the shell variables into a table with room for more of them,
+ * dropping the deleted markers.
+ *
+ * @param variables A pointer to the structure holding the shell variables.
+ */
+static void grow(tvariables *variables)
+{
+    tvariable *table, *slot;
+    int capacity, index;
+
+    table = variables->table;
+    capacity = variables->capacity;
+
+    // Only double the table if it is full of variables, not of markers
+    if (variables->size * 2 >= capacity)
+    {
+        variables->capacity *= 2;
+    }
+
+    variables->table = calloc(variables->capacity, sizeof(tvariable));
+    variables->deleted = 0;
+
+    for (index = 0; index < capacity; index++)
+    {
+        if (table[index].entry != NULL)
+        {
+            slot = lookup(variables, table[index].entry, table[index].nameLength, table[index].hash);
+            *slot = table[index];
+        }
+    }
+
+    free(table);
+}
+
+/**
+ * Get the environment of the commands executed by the shell.
+ *
+ * The array points to the `NAME=value` entries of the exported variables.
+ * It is only rebuilt when an exported variable was set, unset or exported
+ * since the last call, so consecutive commands reuse the same array.
+ *
+ * @param variables A pointer to the structure holding the shell variables.
+ * @return The `NULL` terminated array of exported variables.
+ */
+static char **exportedEnvironment(tvariables *variables)
+{
+    int index, size;
+
+    if (!variables->changed)
+    {
+        return variables->environment;
+    }
+
+    if (variables->environmentCapacity < variables->size + 1)
+    {
+        variables->environmentCapacity = variables->capacity;
+        free(variables->environment);
+        variables->environment = malloc(sizeof(char *) * variables->environmentCapacity);
+    }
+
+    size = 0;
+
+    for (index = 0; index < variables->capacity; index++)
+    {
+        if (variables->table[index].entry != NULL && variables->table[index].exported)
+        {
+            variables->environment[size++] = variables->table[index].entry;
+        }
+    }
+
+    variables->environment[size] = NULL;
+    variables->changed = 0;
+
+    return variables->environment;
+}
+
+/**
+ * Free every variable and the table holding them.
+ *
+ * @param variables A pointer to the structure holding the shell variables.
+ */
+static void releaseVariables(tvariables *variables)
+{
+    int index;
+
+    for (index = 0; index < variables->capacity; index++)
+    {
+        free(variables->table[index].entry);
+    }
+
+    free(variables->table);
+    free(variables->environment);
+}
+
+/**
+ * Check if a string is a valid variable name.
+ *
+ * @param name The name to be checked, which does not need to be null
+ * terminated.
+ * @param length The length of the name.
+ * @return 1 if the name starts with a letter or `_` followed by letters,
+ * digits or `_`, 0 otherwise.
+ */
+static int identifier(const char *name, int length)
+{
+    int index;
+
+    if (length == 0 || (name[0] >= '0' && name[0] <= '9'))
+    {
+        return 0;
+    }
+
+    for (index = 0; index < length; index++)
+    {
+        if (name[index] != '_' && !(name[index] >= 'a' && name[index] <= 'z') && !(name[index] >= 'A' && name[index] <= 'Z') && !(name[index] >= '0' && name[index] <= '9'))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * Check if a word is a variable assignment such as `NAME=value`.
+ *
+ * @param word The word to be checked.
+ * @return 1 if the word is an assignment, 0 otherwise.
+ */
+static int assignment(const char *word)
+{
+    const char *separator;
+
+    separator = strchr(word, ASSIGNMENT);
+
+    return separator != NULL && identifier(word, separator - word);
+}
+
+/**
+ * Get the length of the variable name a string starts with.
+ *
+ * @param text The string to be checked.
+ * @return The number of characters of the longest prefix of `text` that is
+ * a valid variable name, or 0 if there is none.
+ */
+static int nameLength(const char *text)
+{
+    int length;
+
+    if (!identifier(text, 1))
+    {
+        return 0;
+    }
+
+    length = 1;
+    while (identifier(text + length, 1) || (text[length] >= '0' && text[length] <= '9'))
+    {
+        length++;
+    }
+
+    return length;
+}
+
+/**
+ * Replace the variable references of a word by the values of the shell
+ * variables. References to unset variables expand to nothing.
+ *
+ * Besides `$NAME`, `${NAME}` and the `$?` status, the following forms are
+ * supported, where `word` is expanded as well:
+ *   - `${NAME[n]}`: The `n`-th space separated element of the value, such as
+ *     `${PIPESTATUS[0]}`. `${NAME[@]}` and `${NAME[*]}` are the whole value.
+ *   - `${NAME-word}`, `${NAME:-word}`: Use `word` if the variable is unset,
+ *     or if it is unset or empty when the colon is present.
+ *   - `${NAME=word}`, `${NAME:=word}`: Same, also assigning `word` to it.
+ *   - `${NAME+word}`, `${NAME:+word}`: Use `word` if the variable is set, or
+ *     if it is set and not empty when the colon is present.
+ *
+ * @param word The word to be expanded.
+ * @param variables A pointer to the structure holding the shell variables.
+ * @return A heap allocated copy of the word with the references expanded.
+ */
+static char *expandVariables(const char *word, tvariables *variables)
+{
+    tarena expanded;
+    const char *name, *value, *end, *close, *suffix, *subscript, *bracket;
+    char *alternative, *expandedAlternative;
+    char operator;
+    int length, valueLength, colon, set, offset;
+
+    expanded.data = NULL;
+    expanded.size = 0;
+    expanded.capacity = 0;
+    reserve(&expanded, strlen(word) + 1);
+
+    while (*word != '\0')
+    {
+        name = NULL;
+        value = NULL;
+        expandedAlternative = NULL;
+
+        if (word[0] == '$' && word[1] == '{' && (offset = closing(word + 1, '{', '}')) > 0)
+        {
+            name = word + 2;
+            length = parameterLength(name);
+            close = word + 1 + offset;
+            end = close + 1;
+
+            subscript = NULL;
+            suffix = name + length;
+
+            if (*suffix == '[' && (bracket = memchr(suffix, ']', close - suffix)) != NULL)
+            {
+                subscript = suffix + 1;
+                suffix = bracket + 1;
+            }
+
+            colon = *suffix == ':';
+            operator = suffix < close ? suffix[colon] : '\0';
+
+            if (length == 0 || (suffix < close && (suffix + colon >= close || strchr("-=+", operator) == NULL)))
+            {
+                name = NULL;
+            }
+            else
+            {
+                value = getVariable(variables, name, length);
+
+                if (value != NULL && subscript != NULL && *subscript != '@' && *subscript != '*')
+                {
+                    value = element(value, atoi(subscript), &valueLength);
+                    expandedAlternative = value != NULL ? strndup(value, valueLength) : NULL;
+                    value = expandedAlternative;
+                }
+
+                set = value != NULL && (!colon || value[0] != '\0');
+
+                if (((operator == '-' || operator == '=') && !set) || (operator == '+' && set))
+                {
+                    alternative = strndup(suffix + colon + 1, close - (suffix + colon + 1));
+                    free(expandedAlternative);
+                    expandedAlternative = expandVariables(alternative, variables);
+                    free(alternative);
+
+                    if (operator == '=')
+                    {
+                        setVariable(variables, name, length, expandedAlternative, KEEP_EXPORT);
+                    }
+
+                    value = expandedAlternative;
+                }
+                else if (operator == '+')
+                {
+                    value = NULL;
+                }
+            }
+        }
+        else if (word[0] == '$' && (length = parameterLength(word + 1)) > 0)
+        {
+            name = word + 1;
+            end = name + length;
+            value = getVariable(variables, name, length);
+        }
+
+        if (name == NULL)
+        {
+            append(&expanded, word, 1);
+            word++;
+            continue;
+        }
+
+        if (value != NULL)
+        {
+            append(&expanded, value, strlen(value));
+        }
+
+        free(expandedAlternative);
+        word = end;
+    }
+
+    append(&expanded, "", 1);
+
+    return expanded.data;
+}
+
+/**
+ * Set shell variables from a list of `NAME=value` assignments.
+ *
+ * Variables that were already exported stay exported, so their new value
+ * is visible to the commands executed afterwards.
+ *
+ * @param arguments The `NULL` terminated list of assignments.
+ * @param variables A pointer to the structure holding the shell variables.
+ * @return `EXIT_SUCCESS` if every argument is an assignment, `EXIT_FAILURE`
+ * otherwise.
+ */
+static int mshassign(char **arguments, tvariables *variables)
+{
+    char *separator;
+    int index;
+
+    for (index = 0; arguments[index] != NULL; index++)
+    {
+        if (!assignment(arguments[index]))
+        {
+            fprintf(stderr, "%s: Error. Invalid assignment\n", arguments[index]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    for (index = 0; arguments[index] != NULL; index++)
+    {
+        separator = strchr(arguments[index], ASSIGNMENT);
+        setVariable(variables, arguments[index], separator - arguments[index], separator + 1, KEEP_EXPORT);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Set (`-o`) or unset (`+o`) options of the shell. Without an option name,
+ * prints the options.
+ *
+ * The only option is `pipefail`, which makes the status of a pipeline the
+ * one of its last command that failed, instead of the one of its last
+ * command.
+ *
+ * @param arguments The `NULL` terminated argument list, made of `-o name` or
+ * `+o name` pairs after the command.
+ * @param pipefail A pointer to the flag of the `pipefail` option.
+ * @return `EXIT_SUCCESS` if every option is valid, `EXIT_FAILURE` otherwise.
+ */
+static int mshset(char **arguments, int *pipefail)
+{
+    int index;
+
+    if (arguments[1] == NULL || (strcmp(arguments[1], "-o") == 0 && arguments[2] == NULL))
+    {
+        printf("pipefail\t%s\n", *pipefail ? "on" : "off");
+        return EXIT_SUCCESS;
+    }
+
+    for (index = 1; arguments[index] != NULL; index += 2)
+    {
+        if (strcmp(arguments[index], "-o") != 0 && strcmp(arguments[index], "+o") != 0)
+        {
+            fprintf(stderr, "%s: Error. Invalid option\n", arguments[index]);
+            return EXIT_FAILURE;
+        }
+
+        if (arguments[index + 1] == NULL || strcmp(arguments[index + 1], "pipefail") != 0)
+        {
+            fprintf(stderr, "set: Error. Invalid option name\n");
+            return EXIT_FAILURE;
+        }
+
+        *pipefail = arguments[index][0] == '-';
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Export shell variables to the environment of the commands executed
+ * afterwards. Without arguments, prints the exported variables.
+ *
+ * @param arguments The `NULL` terminated argument list, where every argument
+ * after the command is a `NAME` or a `NAME=value` assignment.
+ * @param variables A pointer to the structure holding the shell variables.
+ * @return `EXIT_SUCCESS` if every name is valid, `EXIT_FAILURE` otherwise.
+ */
+static int mshexport(char **arguments, tvariables *variables)
+{
+    char **environment;
+    char *separator;
+    int index, length;
+    int status;
+
+    if (arguments[1] == NULL)
+    {
+        environment = exportedEnvironment(variables);
+
+        for (index = 0; environment[index] != NULL; index++)
+        {
+            printf("export %s\n", environment[index]);
+        }
+        return EXIT_SUCCESS;
+    }
+
+    status = EXIT_SUCCESS;
+
+    for (index = 1; arguments[index] != NULL; index++)
+    {
+        separator = strchr(arguments[index], ASSIGNMENT);
+        length = separator != NULL ? separator - arguments[index] : (int)strlen(arguments[index]);
+
+        if (!identifier(arguments[index], length))
+        {
+            fprintf(stderr, "export: %s: Error. Not a valid identifier\n", arguments[index]);
+            status = EXIT_FAILURE;
+            continue;
+        }
+
+        setVariable(variables, arguments[index], length, separator != NULL ? separator + 1 : NULL, 1);
+    }
+
+    return status;
+}
+
+/**
+ * Remove shell variables, and from the environment if they were exported.
+ *
+ * @param arguments The `NULL` terminated argument list, where every argument
+ * after the command is a variable name.
+ * @param variables A pointer to the structure holding the shell variables.
+ * @return Always `EXIT_SUCCESS`.
+ */
+static int mshunset(char **arguments, tvariables *variables)
+{
+    int index;
+
+    for (index = 1; arguments[index] != NULL; index++)
+    {
+        unsetVariable(variables, arguments[index], strlen(arguments[index]));
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Make room in an arena for at least `size` more bytes.
+ *
+ * @param arena A pointer to the arena.
+ * @param size The number of bytes that will be appended.
+ */
+static void reserve(tarena *arena, int size)
+{
+    if (arena->size + size <= arena->capacity)
+    {
+        return;
+    }
+
+    arena->capacity = arena->capacity * 2 > arena->size + size ? arena->capacity * 2 : arena->size + size;
+    arena->data = realloc(arena->data, arena->capacity);
+}
+
+/**
+ * Append bytes at the end of an arena, growing it if needed.
+ *
+ * @param arena A pointer to the arena.
+ * @param data The bytes to be appended.
+ * @param size The number of bytes to be appended.
+ */
+static void append(tarena *arena, const char *data, int size)
+{
+    reserve(arena, size);
+    memcpy(arena->data + arena->size, data, size);
+    arena->size += size;
+}
+
+/**
+ * Replace the `$(command)` and `` `command` `` substitutions of a command line
+ * by the output of their commands.
+ *
+ * Trailing newlines of the output are removed and the remaining ones become
+ * spaces, so the output is split into words when the line is tokenized.
+ *
+ * @param buffer The command line.
+ * @param shell A pointer to the structure representing the shell state.
+ * @param status A pointer where the exit status of the last substitution is
+ * stored, left unchanged if there is none.
+ * @return A heap allocated copy of the command line with the substitutions
+ * replaced.
+ */
+static char *substitute(const char *buffer, tshell *shell, int *status)
+{
+    tarena substituted;
+    const char *end;
+    char *command;
+    int index, start, length, size;
+
+    substituted.data = NULL;
+    substituted.size = 0;
+    substituted.capacity = 0;
+    reserve(&substituted, strlen(buffer) + 1);
+
+    for (index = 0; buffer[index] != '\0'; index++)
+    {
+        length = -1;
+
+        if (buffer[index] == '$' && buffer[index + 1] == '(')
+        {
+            start = index + 2;
+            length = closing(buffer + index + 1, '(', ')') - 1;
+        }
+        else if (buffer[index] == '`' && (end = strchr(buffer + index + 1, '`')) != NULL)
+        {
+            start = index + 1;
+            length = end - (buffer + start);
+        }
+
+        if (length < 0)
+        {
+            append(&substituted, buffer + index, 1);
+            continue;
+        }
+
+        command = strndup(buffer + start, length);
+        size = substituted.size;
+
+        *status = capture(command, shell, &substituted);
+        free(command);
+
+        while (substituted.size > size && substituted.data[substituted.size - 1] == '\n')
+        {
+            substituted.size--;
+        }
+
+        for (; size < substituted.size; size++)
+        {
+            if (substituted.data[size] == '\n')
+            {
+                substituted.data[size] = ' ';
+            }
+        }
+
+        // Continue after the closing parenthesis or backquote
+        index = start + length;
+    }
+
+    append(&substituted, "", 1);
+
+    return substituted.data;
+}
+
+/**
+ * Find the character closing a bracketed expression, skipping nested ones.
+ *
+ * @param start The expression, starting with the opening character.
+ * @param open The opening character, such as `(`.
+ * @param close The closing character, such as `)`.
+ * @return The offset of the closing character from `start`, or -1 if the
+ * expression is not closed.
+ */
+static int closing(const char *start, const char open, const char close)
+{
+    int index, depth;
+
+    depth = 0;
+
+    for (index = 0; start[index] != '\0'; index++)
+    {
+        if (start[index] == open)
+        {
+            depth++;
+        }
+        else if (start[index] == close && --depth == 0)
+        {
+            return index;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Run a command line and append its standard output to an arena.
+ *
+ * The output is read through a pipe straight into the arena, without
+ * temporary files. Command lines that only call `echo` are evaluated in the
+ * shell itself without forking.
+ *
+ * @param command The command line to be run.
+ * @param shell A pointer to the structure representing the shell state.
+ * @param arena A pointer to the arena where the output is appended.
+ * @return The exit status of the command line, or `EXIT_FAILURE` if it could
+ * not be run.
+ */
+static int capture(const char *command, tshell *shell, tarena *arena)
+{
+    int p[PIPE];
+    pid_t pid;
+    ssize_t bytes;
+    int status;
+
+    if (captureInProcess(command, shell, arena))
+    {
+        return EXIT_SUCCESS;
+    }
+
+    if (pipe(p) != 0)
+    {
+        fprintf(stderr, "%s: Error. %s\n", command, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    // Do not let the child write the pending output of the shell to the pipe
+    fflush(stdout);
+
+    pid = fork();
+
+    if (pid == FORK_CHILD)
+    {
+        // The input buffered by the shell is not the input of the command,
+        // and exiting with it would rewind the offset shared with the shell
+        __fpurge(stdin);
+
+        close(p[PIPE_READ]);
+        dup2(p[PIPE_WRITE], STDOUT_FILENO);
+        close(p[PIPE_WRITE]);
+
+        // The commands write to the pipe, not to the output chosen by the
+        // program embedding the shell, whether forked or sent to a zygote
+        shell->files[STDOUT_FILENO] = STDOUT_FILENO;
+
+        // Stopped by `Ctrl+C` like a command, while still ignoring the job
+        // control signals, since it gives the terminal to its commands and
+        // takes it back like the shell
+        signal(SIGINT, SIG_DFL);
+        signal(SIGQUIT, SIG_DFL);
+
+        // The zygotes are children of the shell, not of this process
+        closeZygotes(&shell->zygotes);
+
+        leave(executeList(command, shell));
+    }
+
+    close(p[PIPE_WRITE]);
+
+    while (pid > 0)
+    {
+        reserve(arena, READ_SIZE);
+        bytes = read(p[PIPE_READ], arena->data + arena->size, READ_SIZE);
+
+        if (bytes < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (bytes <= 0)
+        {
+            break;
+        }
+
+        arena->size += bytes;
+    }
+
+    close(p[PIPE_READ]);
+
+    if (pid < 0 || waitpid(pid, &status, WAIT) < 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    return exitStatus(status);
+}
+
+/**
+ * Evaluate a command substitution in the shell itself if it only calls
+ * `echo` and assigns no variable, appending the output to an arena. Its
+ * exit status is always `EXIT_SUCCESS`.
+ *
+ * @param command The command line to be evaluated.
+ * @param shell A pointer to the structure representing the shell state.
+ * @param arena A pointer to the arena where the output is appended.
+ * @return 1 if the command line was evaluated, 0 if it must be run in a
+ * child process.
+ */
+static int captureInProcess(const char *command, tshell *shell, tarena *arena)
+{
+    tline *line;
+    tline *expandedLine;
+    char **arguments;
+    char *copy;
+    int index, first, handled;
+
+    while (*command == ' ' || *command == '\t')
+    {
+        command++;
+    }
+
+    // Avoid tokenizing lines that will be run in a child anyway, and lines
+    // that may assign variables, such as `${X:=v}`, which must not change
+    // the shell
+    if (strncmp(command, "echo", 4) != 0 || (command[4] != ' ' && command[4] != '\t' && command[4] != '\0') || strpbrk(command, ";&|<>`=") != NULL || strstr(command, "$(") != NULL)
+    {
+        return 0;
+    }
+
+    copy = strdup(command);
+    line = tokenize(copy);
+    handled = 0;
+
+    if (line != NULL && line->ncommands == 1 && !line->background && line->redirect_input == NULL && line->redirect_output == NULL && line->redirect_error == NULL)
+    {
+        expandedLine = expand(line, &shell->variables);
+        arguments = expandedLine->commands[0].argv;
+
+        first = arguments[1] != NULL && strcmp(arguments[1], "-n") == 0 ? 2 : 1;
+
+        for (index = first; arguments[index] != NULL; index++)
+        {
+            if (index > first)
+            {
+                append(arena, " ", 1);
+            }
+            append(arena, arguments[index], strlen(arguments[index]));
+        }
+
+        release(expandedLine);
+        handled = 1;
+    }
+
+    free(copy);
+
+    return handled;
+}
+
+/**
+ * Parse a command line into a tree of pipelines.
+ *
+ * The grammar is the one of `sh` lists: pipelines are joined by `&&` and
+ * `||`, which bind tighter than `;` and `&`. A pipeline followed by `&` is
+ * executed in background, and `$(...)` and `` `...` `` substitutions are kept
+ * inside the pipeline they belong to.
+ *
+ * @param buffer The command line to be parsed.
+ * @param error Pointer to the variable set to 1 if the line has a syntax
+ * error, or to 0 otherwise.
+ * @return The root of the tree, or NULL if the line has no pipelines. Even on
+ * error, the tree must be freed with `destroy()`.
+ */
+static tnode *parse(const char *buffer, int *error)
+{
+    const char *cursor;
+
+    *error = 0;
+    cursor = buffer;
+
+    return parseList(&cursor, error);
+}
+
+/**
+ * Parse a list of and-or chains separated by `;` or `&`.
+ *
+ * @param cursor Pointer to the position in the line where the list starts,
+ * advanced past the parsed text.
+ * @param error Pointer to the variable set to 1 on syntax error.
+ * @return The tree of the list, or NULL if it is empty.
+ */
+static tnode *parseList(const char **cursor, int *error)
+{
+    tnode *node, *right;
+
+    node = parseAndOr(cursor, error);
+
+    while (!*error && **cursor != '\0' && **cursor != '\n')
+    {
+        if (**cursor == ';')
+        {
+            (*cursor)++;
+        }
+
+        right = parseAndOr(cursor, error);
+
+        if (node == NULL || right == NULL)
+        {
+            node = node == NULL ? right : node;
+        }
+        else
+        {
+            node = combine(NODE_SEQUENCE, node, right);
+        }
+    }
+
+    return node;
+}
+
+/**
+ * Parse a chain of pipelines joined by `&&` and `||`, which are left
+ * associative and have the same precedence.
+ *
+ * @param cursor Pointer to the position in the line where the chain starts,
+ * advanced past the parsed text.
+ * @param error Pointer to the variable set to 1 on syntax error.
+ * @return The tree of the chain, or NULL if it is empty.
+ */
+static tnode *parseAndOr(const char **cursor, int *error)
+{
+    tnode *left, *right;
+    int type;
+
+    left = parsePipeline(cursor, error);
+
+    while (!*error && separator(*cursor, *cursor) == 2)
+    {
+        type = **cursor == '&' ? NODE_AND : NODE_OR;
+        *cursor += 2;
+
+        right = parsePipeline(cursor, error);
+
+        // Both sides of `&&` and `||` are mandatory
+        if (left == NULL || right == NULL)
+        {
+            *error = 1;
+        }
+
+        left = combine(type, left, right);
+    }
+
+    return left;
+}
+
+/**
+ * Parse a pipeline, which spans until the next list operator or the end of
+ * the line. A trailing `&` is kept in the pipeline text so the parser marks
+ * it as a background pipeline.
+ *
+ * @param cursor Pointer to the position in the line where the pipeline
+ * starts, advanced past the parsed text.
+ * @param error Pointer to the variable set to 1 on syntax error.
+ * @return The pipeline node, or NULL if the pipeline is empty.
+ */
+static tnode *parsePipeline(const char **cursor, int *error)
+{
+    const char *start, *end, *backquote;
+    tnode *node;
+    int offset, background, length, index;
+
+    start = *cursor;
+
+    for (end = start; *end != '\0' && *end != '\n'; end++)
+    {
+        if (end[0] == '$' && end[1] == '(' && (offset = closing(end + 1, '(', ')')) > 0)
+        {
+            end += offset + 1;
+            continue;
+        }
+
+        if (end[0] == '`' && (backquote = strchr(end + 1, '`')) != NULL)
+        {
+            end = backquote;
+            continue;
+        }
+
+        // The parallel operator is not an `||` followed by a pipe
+        if (strncmp(end, PARALLEL_OPERATOR, strlen(PARALLEL_OPERATOR)) == 0)
+        {
+            end += strlen(PARALLEL_OPERATOR) - 1;
+            continue;
+        }
+
+        // The branches of a fan-out are separated by `;`
+        if (strncmp(end, FAN_OUT, strlen(FAN_OUT)) == 0 && (offset = closing(end + 1, '{', '}')) > 0)
+        {
+            end += offset + 1;
+            continue;
+        }
+
+        if (separator(end, start) > 0)
+        {
+            break;
+        }
+    }
+
+    background = end[0] == '&' && end[1] != '&';
+    length = end - start + background;
+    *cursor = end + background;
+
+    for (index = 0; index < length && (start[index] == ' ' || start[index] == '\t'); index++)
+    {
+    }
+
+    if (index == length || start[index] == '&')
+    {
+        // A lone `&` has no pipeline to send to the background
+        *error |= background;
+        return NULL;
+    }
+
+    node = combine(NODE_PIPELINE, NULL, NULL);
+    node->text = malloc(length + 2);
+    memcpy(node->text, start, length);
+    node->text[length] = '\n';
+    node->text[length + 1] = '\0';
+
+    return node;
+}
+
+/**
+ * Create a node of the tree a command line is parsed into.
+ *
+ * @param type The type of the node, such as `NODE_PIPELINE` or `NODE_AND`.
+ * @param left The first operand of the node, or NULL.
+ * @param right The second operand of the node, or NULL.
+ * @return The new node, without text.
+ */
+static tnode *combine(const int type, tnode *left, tnode *right)
+{
+    tnode *node;
+
+    node = malloc(sizeof(tnode));
+    node->type = type;
+    node->text = NULL;
+    node->left = left;
+    node->right = right;
+
+    return node;
+}
+
+/**
+ * Check if a list operator starts at a position of a command line.
+ *
+ * @param cursor The position to be checked.
+ * @param start The start of the pipeline being parsed, so `>&` redirections
+ * are not taken for a `&` operator.
+ * @return 2 for `&&` and `||`, 1 for `;` and `&`, and 0 otherwise.
+ */
+static int separator(const char *cursor, const char *start)
+{
+    if ((cursor[0] == '&' && cursor[1] == '&') || (cursor[0] == '|' && cursor[1] == '|'))
+    {
+        return 2;
+    }
+
+    if (cursor[0] == ';' || (cursor[0] == '&' && (cursor == start || cursor[-1] != '>')))
+    {
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Evaluate a tree of pipelines, short-circuiting `&&` and `||` on the exit
+ * status of their left side. Nothing else is evaluated once `exit` ran.
+ *
+ * @param node The root of the tree.
+ * @param shell A pointer to the structure representing the shell state.
+ * @return The exit status of the last pipeline executed.
+ */
+static int evaluate(const tnode *node, tshell *shell)
+{
+    int status;
+
+    switch (node->type)
+    {
+    case NODE_PIPELINE:
+        return executeLine(node->text, shell);
+
+    case NODE_AND:
+        status = evaluate(node->left, shell);
+        return status == EXIT_SUCCESS && !shell->exited ? evaluate(node->right, shell) : status;
+
+    case NODE_OR:
+        status = evaluate(node->left, shell);
+        return status != EXIT_SUCCESS && !shell->exited ? evaluate(node->right, shell) : status;
+
+    default:
+        status = evaluate(node->left, shell);
+        return !shell->exited ? evaluate(node->right, shell) : status;
+    }
+}
+
+/**
+ * Free a tree returned by `parse()`.
+ *
+ * @param node The root of the tree, or NULL.
+ */
+static void destroy(tnode *node)
+{
+    if (node == NULL)
+    {
+        return;
+    }
+
+    destroy(node->left);
+    destroy(node->right);
+    free(node->text);
+    free(node);
+}
+
+/**
+ * Convert a status returned by `waitpid()` into an exit status.
+ *
+ * @param status The status returned by `waitpid()`.
+ * @return The exit code of the process, or `SIGNAL_STATUS` plus the signal
+ * number if it was terminated by a signal.
+ */
+static int exitStatus(const int status)
+{
+    if (WIFSIGNALED(status))
+    {
+        return SIGNAL_STATUS + WTERMSIG(status);
+    }
+
+    return WEXITSTATUS(status);
+}
+
+/**
+ * Record a newly started process of a job.
+ *
+ * @param job The structure representing the job.
+ * @param index The position of the process within the job.
+ * @param pid The process identifier.
+ */
+static void addProcess(tjob *job, const int index, const pid_t pid)
+{
+    job->processes[index].pid = pid;
+    job->processes[index].reaped = 0;
+    job->processes[index].status = 0;
+    memset(&job->processes[index].usage, 0, sizeof(struct rusage));
+}
+
+/**
+ * Wait for a process to finish or stop, recording its status and the
+ * resources it used with the same `wait4()` call.
+ *
+ * @param process The structure representing the process.
+ * @return The signal that stopped the process, or 0 if it finished.
+ */
+static int waitProcess(tprocess *process)
+{
+    pid_t pid;
+    int status;
+
+    do
+    {
+        pid = wait4(process->pid, &status, WUNTRACED, &process->usage);
+    } while (pid < 0 && errno == EINTR);
+
+    if (pid > 0 && WIFSTOPPED(status))
+    {
+        return WSTOPSIG(status);
+    }
+
+    process->status = status;
+    process->reaped = 1;
+
+    return 0;
+}
+
+/**
+ * Reap every background process that has finished, without blocking, and
+ * record its status and resource usage in its job. Jobs whose processes were
+ * stopped or resumed by a signal are marked accordingly.
+ *
+ * Only the process group of every job is waited for, so the children of the
+ * program embedding the shell, and the ones of other shells in the same
+ * process, are left alone. In subreaper mode the orphaned descendants
+ * adopted by the shell that stayed in the group of their job are reaped too,
+ * and charged to it. Orphans that moved to a group of their own, such as
+ * daemons, cannot be told apart from other children and are not reaped.
+ *
+ * @param jobs A pointer to the structure representing the list of active jobs.
+ */
+static void reap(tjobs *jobs)
+{
+    struct rusage usage;
+    pid_t pid, group;
+    int status;
+    int j;
+
+    for (j = 0; j < jobs->size; j++)
+    {
+        group = jobs->list[j].pgid;
+
+        if (group <= 0)
+        {
+            continue;
+        }
+
+        while ((pid = wait4(-group, &status, WNOHANG | WUNTRACED | WCONTINUED, &usage)) > 0)
+        {
+            charge(jobs, pid, jobs->subreaper ? group : 0, status, &usage);
+        }
+    }
+}
+
+/**
+ * Record the status reported by `wait4()` for a child of the shell in the
+ * job it belongs to.
+ *
+ * @param jobs A pointer to the structure representing the list of active jobs.
+ * @param pid The identifier of the child.
+ * @param group The process group of the child if it may be an adopted
+ * descendant, or 0.
+ * @param status The status reported by `wait4()`.
+ * @param usage The resources used by the child.
+ * @return 1 if the child was found in a job, 0 otherwise.
+ */
+static int charge(tjobs *jobs, const pid_t pid, const pid_t group, const int status, const struct rusage *usage)
+{
+    tprocess *process;
+    tjob *job;
+    int j, index;
+
+    for (j = 0; j < jobs->size; j++)
+    {
+        job = &jobs->list[j];
+
+        for (index = 0; index < job->size; index++)
+        {
+            process = &job->processes[index];
+
+            if (process->pid != pid || process->reaped)
+            {
+                continue;
+            }
+
+            if (WIFSTOPPED(status) || WIFCONTINUED(status))
+            {
+                job->stopped = WIFSTOPPED(status);
+            }
+            else
+            {
+                process->reaped = 1;
+                process->status = status;
+                process->usage = *usage;
+
+                terminateUpstream(job, index);
+            }
+
+            return 1;
+        }
+    }
+
+    if (group <= 0 || WIFSTOPPED(status) || WIFCONTINUED(status))
+    {
+        return 0;
+    }
+
+    for (j = 0; j < jobs->size; j++)
+    {
+        job = &jobs->list[j];
+
+        if (job->pgid == group && !job->finished)
+        {
+            job->orphans++;
+            addUsage(&job->orphanUsage, usage);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Add the resources used by a process to a total.
+ *
+ * Times and counters are added up, and the maximum resident set size is the
+ * largest of both.
+ *
+ * @param total The resources to be increased.
+ * @param usage The resources used by the process.
+ */
+static void addUsage(struct rusage *total, const struct rusage *usage)
+{
+    timeradd(&total->ru_utime, &usage->ru_utime, &total->ru_utime);
+    timeradd(&total->ru_stime, &usage->ru_stime, &total->ru_stime);
+
+    if (usage->ru_maxrss > total->ru_maxrss)
+    {
+        total->ru_maxrss = usage->ru_maxrss;
+    }
+
+    total->ru_minflt += usage->ru_minflt;
+    total->ru_majflt += usage->ru_majflt;
+    total->ru_inblock += usage->ru_inblock;
+    total->ru_oublock += usage->ru_oublock;
+    total->ru_nvcsw += usage->ru_nvcsw;
+    total->ru_nivcsw += usage->ru_nivcsw;
+}
+
+/**
+ * Update the `?` and `PIPESTATUS` variables and the result returned by
+ * `msh_run()` after executing a pipeline.
+ *
+ * @param shell A pointer to the structure representing the shell state.
+ * @param job The processes of the pipeline, or NULL if it only has a single
+ * status, such as internal commands and background jobs.
+ * @param status The exit status of the pipeline.
+ */
+static void setStatus(tshell *shell, const tjob *job, const int status)
+{
+    char value[MAXIMUM_PID_LIST_SIZE * 4 + 1];
+    int index, length;
+
+    length = 0;
+
+    if (job == NULL)
+    {
+        memset(&shell->result, 0, sizeof(msh_result));
+        shell->result.size = 1;
+        shell->result.statuses[0] = status;
+    }
+    else
+    {
+        collect(job, &shell->result);
+    }
+
+    shell->result.status = status;
+
+    for (index = 0; index < shell->result.size; index++)
+    {
+        length += sprintf(value + length, index == 0 ? "%i" : " %i", shell->result.statuses[index]);
+    }
+
+    setVariable(&shell->variables, PIPESTATUS, strlen(PIPESTATUS), value, KEEP_EXPORT);
+
+    sprintf(value, "%i", status);
+    setVariable(&shell->variables, STATUS, strlen(STATUS), value, KEEP_EXPORT);
+}
+
+/**
+ * Fill the outcome of a job with the exit status and the resources used by
+ * each of its processes.
+ *
+ * @param job The structure representing the job.
+ * @param result Where the outcome is stored.
+ */
+static void collect(const tjob *job, msh_result *result)
+{
+    int index;
+
+    memset(result, 0, sizeof(msh_result));
+    result->size = job->size;
+    result->usage = job->orphanUsage;
+
+    for (index = 0; index < job->size; index++)
+    {
+        result->statuses[index] = exitStatus(job->processes[index].status);
+        addUsage(&result->usage, &job->processes[index].usage);
+    }
+
+    result->status = jobStatus(job);
+}
+
+/**
+ * Get the length of the parameter name a string starts with, which is
+ * either a variable name or the `?` special parameter.
+ *
+ * @param text The string to be checked.
+ * @return The length of the parameter name, or 0 if there is none.
+ */
+static int parameterLength(const char *text)
+{
+    if (text[0] == STATUS[0])
+    {
+        return 1;
+    }
+
+    return nameLength(text);
+}
+
+/**
+ * Find an element of a list of values separated by spaces.
+ *
+ * @param value The list of values.
+ * @param index The position of the element, starting at 0.
+ * @param length Pointer to the variable to store the length of the element.
+ * @return A pointer to the element within `value`, or NULL if the list has
+ * fewer elements.
+ */
+static const char *element(const char *value, int index, int *length)
+{
+    while (*value == ' ')
+    {
+        value++;
+    }
+
+    while (index > 0 && *value != '\0')
+    {
+        value += strcspn(value, " ");
+        value += strspn(value, " ");
+        index--;
+    }
+
+    if (index < 0 || *value == '\0')
+    {
+        return NULL;
+    }
+
+    *length = strcspn(value, " ");
+
+    return value;
+}
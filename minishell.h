@@ -0,0 +1,194 @@
+#ifndef MINISHELL_H
+#define MINISHELL_H
+
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+/**
+ * Maximum number of characters of a command line, including its trailing
+ * newline.
+ */
+#define MSH_MAXIMUM_LINE_LENGTH 1024
+
+/**
+ * Maximum number of commands of a pipeline.
+ */
+#define MSH_MAXIMUM_COMMANDS 25
+
+/**
+ * Opaque structure holding the whole state of a shell: its variables, jobs,
+ * zygotes and standard files. Several contexts can live in the same process,
+ * since the library has no global state.
+ */
+typedef struct msh_context msh_context;
+
+/**
+ * Structure representing the outcome of a pipeline.
+ *
+ * Fields:
+ *   - status: The exit status of the pipeline, as stored in `$?`.
+ *   - size: The number of commands of the pipeline, or 1 for internal
+ *     commands.
+ *   - statuses: The exit status of every command, as stored in
+ *     `PIPESTATUS`.
+ *   - usage: The resources used by the commands of the pipeline.
+ */
+typedef struct
+{
+    int status;
+    int size;
+    int statuses[MSH_MAXIMUM_COMMANDS];
+    struct rusage usage;
+} msh_result;
+
+/**
+ * Function called when a pipeline started with `msh_start()` finishes.
+ *
+ * @param context The shell the pipeline ran in.
+ * @param job The number the job had when it finished.
+ * @param result The outcome of the pipeline.
+ * @param data The pointer given to `msh_start()`.
+ */
+typedef void (*msh_callback)(msh_context *context, int job, const msh_result *result, void *data);
+
+/**
+ * Function executing a builtin loaded with `enable -f library name`, which a
+ * shared object exports as the `name_builtin` symbol.
+ *
+ * A builtin alone in a foreground command line runs inside the shell, with
+ * the redirections of the line applied to the standard file descriptors; in
+ * a pipeline or in background it runs in the forked child without executing
+ * any program. It must return instead of calling `exit()`, and should read
+ * its input from `STDIN_FILENO` rather than `stdin`, whose buffer is shared
+ * with the shell.
+ *
+ * @param argc The number of arguments, including the name of the builtin.
+ * @param argv The `NULL` terminated array of arguments.
+ * @param environment The `NULL` terminated array of exported variables.
+ * @return The exit status of the builtin.
+ */
+typedef int (*msh_builtin)(int argc, char **argv, char **environment);
+
+/**
+ * Create a shell whose variables are initialized from an environment.
+ *
+ * The `MSH_SUBREAPER` and `MSH_ZYGOTES` variables of the environment are
+ * honoured, as in the `minishell` executable.
+ *
+ * @param environment The `NULL` terminated array of `NAME=value` strings.
+ * @return The new shell, to be freed with `msh_destroy()`.
+ */
+msh_context *msh_create(char **environment);
+
+/**
+ * Free a shell created by `msh_create()`, stopping its zygotes. Its jobs
+ * keep running.
+ *
+ * @param context The shell.
+ */
+void msh_destroy(msh_context *context);
+
+/**
+ * Set the standard input, output and error of the commands executed
+ * afterwards. Redirections of a command line still take precedence.
+ *
+ * @param context The shell.
+ * @param input The standard input of the commands.
+ * @param output The standard output of the commands.
+ * @param error The standard error of the commands.
+ */
+void msh_set_files(msh_context *context, int input, int output, int error);
+
+/**
+ * Execute a command line, such as `a | b > f && c`, and wait for it.
+ *
+ * @param context The shell.
+ * @param line The command line, with or without a trailing newline.
+ * @param result Where the outcome of the last pipeline executed is stored,
+ * or NULL.
+ * @return The exit status of the command line, or -1 if it is too long.
+ */
+int msh_run(msh_context *context, const char *line, msh_result *result);
+
+/**
+ * Start a pipeline in background without waiting for it.
+ *
+ * The callback is called from `msh_poll()` once every command of the
+ * pipeline has finished. If the line is an internal command, it runs at
+ * once and the callback is called before returning.
+ *
+ * @param context The shell.
+ * @param line The pipeline, without a trailing `&`.
+ * @param callback The function called when the pipeline finishes, or NULL.
+ * @param data A pointer handed to the callback.
+ * @return The number of the job, 0 if the line ran at once, or -1 if it is
+ * too long or the list of jobs is full.
+ */
+int msh_start(msh_context *context, const char *line, msh_callback callback, void *data);
+
+/**
+ * Reap the jobs that finished since the last call, without blocking, and
+ * call the callbacks of the ones started with `msh_start()`.
+ *
+ * @param context The shell.
+ * @return The number of callbacks called.
+ */
+int msh_poll(msh_context *context);
+
+/**
+ * Wait until a file can be read, reaping the background jobs as they finish
+ * and starting the commands queued with `submit` as slots become free. The
+ * callbacks of the jobs are called meanwhile, as in `msh_poll()`.
+ *
+ * Data already buffered by `stdio` is not seen, so it suits a terminal,
+ * which delivers a whole line at a time.
+ *
+ * @param context The shell.
+ * @param file The file descriptor, or -1 to wait until every command queued
+ * with `submit` has finished.
+ * @return 1 if the file can be read, 0 otherwise.
+ */
+int msh_wait(msh_context *context, int file);
+
+/**
+ * Enable job control if the standard input is a terminal: the process
+ * moves to its own process group, takes the terminal and ignores the job
+ * control signals.
+ *
+ * @param context The shell.
+ * @return 1 if job control was enabled, 0 otherwise.
+ */
+int msh_enable_job_control(msh_context *context);
+
+/**
+ * Get the process group of the job running in the foreground. It only reads
+ * a `sig_atomic_t` field, so it can be called from a signal handler.
+ *
+ * @param context The shell.
+ * @return The process group, or 0 if nothing is running in the foreground.
+ */
+pid_t msh_foreground(const msh_context *context);
+
+/**
+ * Check whether the `exit` builtin was executed. It ends every job but not
+ * the calling process, so it is up to the caller to destroy the shell and
+ * exit.
+ *
+ * @param context The shell.
+ * @return 1 if `exit` was executed, 0 otherwise.
+ */
+int msh_exited(const msh_context *context);
+
+/**
+ * Serve command lines received on a Unix domain socket, forking a child of
+ * the shell for every client.
+ *
+ * @param context The shell.
+ * @param path The path of the socket, which is replaced if it exists.
+ * @return `EXIT_FAILURE` if the socket could not be created, since it never
+ * returns otherwise.
+ */
+int msh_serve(msh_context *context, const char *path);
+
+#endif
@@ -0,0 +1,44 @@
+#!/bin/bash
+
+# Checks that `MSH_MAXIMUM_CHILDREN` makes command lines wait for room
+# without ever waiting for themselves.
+#
+# Usage: tests/admission.sh [path to minishell]
+
+MINISHELL=${1:-./minishell}
+FAILED=0
+
+# Runs the given lines with at most two commands at once and prints the
+# output without prompts, giving up after ten seconds
+run()
+{
+    printf '%s\n' "export MSH_MAXIMUM_CHILDREN=2" "$@" | timeout 10 "$MINISHELL" 2>&1 | sed 's/msh> //g' | grep -v '^\['
+}
+
+check()
+{
+    if [ "$2" != "$3" ]
+    then
+        echo "FAIL: $1: expected '$3', got '$2'"
+        FAILED=1
+    else
+        echo "ok: $1"
+    fi
+}
+
+check "pipeline behind a job" "$(run "sleep 1 &" "yes | head -1")" "y"
+
+# No command of a waiting line is started, or it could hold its slot while
+# waiting for the rest of the line
+printf '%s\n' "export MSH_MAXIMUM_CHILDREN=2" "sleep 2 &" "yes | head -1" | "$MINISHELL" > /dev/null 2>&1 &
+sleep 1
+check "nothing started while waiting" "$(pgrep -c -P $! -x yes)" "0"
+wait
+
+check "pipeline longer than the maximum" "$(run "echo a | cat | cat | cat")" "a"
+
+START=$(date +%s%N)
+run "sleep 1 &" "sleep 1 &" "true" > /dev/null
+check "waits for room" "$(( ($(date +%s%N) - START) >= 1000000000 ))" "1"
+
+exit $FAILED
@@ -0,0 +1,47 @@
+#!/bin/bash
+
+# Checks that `|{ ... }` hands the whole input to every branch, even to slow
+# ones, merges their outputs, and reports the first branch that failed.
+#
+# Usage: tests/fanout.sh [path to minishell]
+
+MINISHELL=${1:-./minishell}
+DIRECTORY=$(mktemp -d)
+FAILED=0
+
+trap 'rm -rf "$DIRECTORY"' EXIT
+
+# Runs the given lines and prints the output without prompts, giving up
+# after twenty seconds
+run()
+{
+    printf '%s\n' "$@" | timeout 20 "$MINISHELL" 2>&1 | sed 's/msh> //g'
+}
+
+check()
+{
+    if [ "$2" != "$3" ]
+    then
+        echo "FAIL: $1: expected '$3', got '$2'"
+        FAILED=1
+    else
+        echo "ok: $1"
+    fi
+}
+
+seq 2000000 > "$DIRECTORY/numbers"
+SUM=$(cksum < "$DIRECTORY/numbers")
+
+# A branch that starts reading late fills its pipe, so the others get
+# blocks it only partly took
+printf '#!/bin/sh\nsleep 0.5\ncksum\n' > "$DIRECTORY/late"
+chmod +x "$DIRECTORY/late"
+
+check "every branch" "$(run "cat $DIRECTORY/numbers |{ cksum ; cksum }")" "$(printf '%s\n%s' "$SUM" "$SUM")"
+check "late branch" "$(run "cat $DIRECTORY/numbers |{ $DIRECTORY/late ; cksum ; $DIRECTORY/late }")" "$(printf '%s\n%s\n%s' "$SUM" "$SUM" "$SUM")"
+check "redirections" "$(run "cat $DIRECTORY/numbers |{ cksum > $DIRECTORY/sum ; wc -l }" "cat $DIRECTORY/sum" | tr -d ' ' | tr '\n' ' ')" "2000000 $(echo "$SUM" | tr -d ' ') "
+check "merged into the rest" "$(run "seq 3 |{ cat ; cat } | sort -n | uniq -c | wc -l" | tr -d ' ')" "3"
+check "branch that exits" "$(run "cat $DIRECTORY/numbers |{ head -1 ; wc -l }" | tr -d ' ' | sort | tr '\n' ' ')" "1 2000000 "
+check "failed branch" "$(run "seq 3 |{ cat > /dev/null ; false ; true }" 'echo $?' | tail -1)" "1"
+
+exit $FAILED
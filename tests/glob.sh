@@ -0,0 +1,42 @@
+#!/bin/bash
+
+# Checks that words with `*`, `?`, `[...]` and `**` are replaced by the
+# sorted list of paths they match, and left alone when nothing matches.
+#
+# Usage: tests/glob.sh [path to minishell]
+
+MINISHELL=${1:-./minishell}
+DIRECTORY=$(mktemp -d)
+FAILED=0
+
+trap 'rm -rf "$DIRECTORY"' EXIT
+
+# Runs the given lines in the test directory and prints the output without
+# prompts
+run()
+{
+    printf '%s\n' "cd $DIRECTORY" "$@" | "$MINISHELL" 2>&1 | sed 's/msh> //g'
+}
+
+check()
+{
+    if [ "$2" != "$3" ]
+    then
+        echo "FAIL: $1: expected '$3', got '$2'"
+        FAILED=1
+    else
+        echo "ok: $1"
+    fi
+}
+
+mkdir -p "$DIRECTORY/sub/deep"
+touch "$DIRECTORY/b.txt" "$DIRECTORY/a.txt" "$DIRECTORY/c.log" "$DIRECTORY/.hidden.txt" "$DIRECTORY/sub/d.txt" "$DIRECTORY/sub/deep/e.txt"
+
+check "star" "$(run "echo *.txt")" "a.txt b.txt"
+check "question mark" "$(run "echo ?.log")" "c.log"
+check "bracket" "$(run "echo [bc].*")" "b.txt c.log"
+check "recursive" "$(run "echo **/*.txt")" "a.txt b.txt sub/d.txt sub/deep/e.txt"
+check "directories only" "$(run "echo */")" "sub/"
+check "no match" "$(run "echo *.none")" "*.none"
+
+exit $FAILED
@@ -0,0 +1,47 @@
+#!/bin/bash
+
+# Checks that `|||N` hands every line of its input to exactly one instance,
+# keeps the order with `k`, routes equal keys together with `h`, and fails
+# when lines could not be delivered.
+#
+# Usage: tests/instances.sh [path to minishell]
+
+MINISHELL=${1:-./minishell}
+DIRECTORY=$(mktemp -d)
+FAILED=0
+
+trap 'rm -rf "$DIRECTORY"' EXIT
+
+# Runs the given lines and prints the output without prompts, giving up
+# after ten seconds
+run()
+{
+    printf '%s\n' "$@" | timeout 10 "$MINISHELL" 2>&1 | sed 's/msh> //g'
+}
+
+check()
+{
+    if [ "$2" != "$3" ]
+    then
+        echo "FAIL: $1: expected '$3', got '$2'"
+        FAILED=1
+    else
+        echo "ok: $1"
+    fi
+}
+
+seq 200000 > "$DIRECTORY/numbers"
+
+for key in $(seq 50)
+do
+    printf 'key%s\nkey%s\nkey%s\n' "$key" "$key" "$key"
+done > "$DIRECTORY/keys"
+
+check "round robin" "$(run "cat $DIRECTORY/numbers |||4 cat | sort -n | cksum")" "$(cksum < "$DIRECTORY/numbers")"
+check "ordered" "$(run "cat $DIRECTORY/numbers |||3k cat | cksum")" "$(cksum < "$DIRECTORY/numbers")"
+check "hash" "$(run "cat $DIRECTORY/numbers |||4h cat | sort -n | cksum")" "$(cksum < "$DIRECTORY/numbers")"
+check "equal keys together" "$(run "cat $DIRECTORY/keys |||4h uniq | wc -l" | tr -d ' ')" "50"
+check "failed instance" "$(run "cat $DIRECTORY/numbers |||4 false" 'echo $?' | tail -1)" "1"
+check "lost lines" "$(run "cat $DIRECTORY/numbers |||4h head -1 > /dev/null" 'echo $?' | tail -1)" "1"
+
+exit $FAILED
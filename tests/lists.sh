@@ -0,0 +1,35 @@
+#!/bin/bash
+
+# Checks that `;`, `&&` and `||` run the pipelines of a line in order, each
+# one depending on the status of the previous ones.
+#
+# Usage: tests/lists.sh [path to minishell]
+
+MINISHELL=${1:-./minishell}
+FAILED=0
+
+# Runs the given lines and prints the output without prompts
+run()
+{
+    printf '%s\n' "$@" | "$MINISHELL" 2>&1 | sed 's/msh> //g'
+}
+
+check()
+{
+    if [ "$2" != "$3" ]
+    then
+        echo "FAIL: $1: expected '$3', got '$2'"
+        FAILED=1
+    else
+        echo "ok: $1"
+    fi
+}
+
+check "sequence" "$(run "echo a ; false ; echo b" | tr '\n' ' ')" "a b "
+check "status of a sequence" "$(run "true ; false" 'echo $?')" "1"
+check "and" "$(run "true && echo a" "false && echo b")" "a"
+check "or" "$(run "true || echo a" "false || echo b")" "b"
+check "left to right" "$(run "false && echo a || echo b" "false || false && echo c")" "b"
+check "pipelines" "$(run "echo a b | wc -w && echo c | tr c d" | tr -d ' ' | tr '\n' ' ')" "2 d "
+
+exit $FAILED
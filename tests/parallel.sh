@@ -0,0 +1,47 @@
+#!/bin/bash
+
+# Checks that `parallel` runs a command once per item, with at most the given
+# number at once, and reports the first item that failed.
+#
+# Usage: tests/parallel.sh [path to minishell]
+
+MINISHELL=${1:-./minishell}
+FAILED=0
+
+# Runs the given lines and prints the output without prompts, giving up
+# after twenty seconds
+run()
+{
+    printf '%s\n' "$@" | timeout 20 "$MINISHELL" 2>&1 | sed 's/msh> //g'
+}
+
+check()
+{
+    if [ "$2" != "$3" ]
+    then
+        echo "FAIL: $1: expected '$3', got '$2'"
+        FAILED=1
+    else
+        echo "ok: $1"
+    fi
+}
+
+# Seconds taken by the given lines
+elapsed()
+{
+    local start
+
+    start=$(date +%s%N)
+    run "$@" > /dev/null
+    echo $(( ($(date +%s%N) - start) / 1000000000 ))
+}
+
+check "arguments" "$(run "parallel -j 2 echo item {} ::: a b c" | sort | tr '\n' ' ')" "item a item b item c "
+check "appended item" "$(run "parallel echo ::: a b" | sort | tr '\n' ' ')" "a b "
+check "standard input" "$(run "seq 5 | parallel -j 3 echo" | sort -n | tr '\n' ' ')" "1 2 3 4 5 "
+check "first failure by item" "$(run "parallel -j 2 grep -s x {} ::: /dev/null /nonexistent" 'echo $?' | tail -1)" "1"
+check "first failure by item, reversed" "$(run "parallel -j 2 grep -s x {} ::: /nonexistent /dev/null" 'echo $?' | tail -1)" "2"
+check "two at once" "$(elapsed "parallel -j 2 sleep ::: 1 1 1 1")" "2"
+check "four at once" "$(elapsed "parallel -j 4 sleep ::: 1 1 1 1")" "1"
+
+exit $FAILED
@@ -0,0 +1,36 @@
+#!/bin/bash
+
+# Checks the status of pipelines with and without `set -o pipefail`, and that
+# the commands feeding one that exited early are stopped.
+#
+# Usage: tests/pipefail.sh [path to minishell]
+
+MINISHELL=${1:-./minishell}
+FAILED=0
+
+# Runs the given lines and prints the output without prompts, giving up
+# after ten seconds
+run()
+{
+    printf '%s\n' "$@" | timeout 10 "$MINISHELL" 2>&1 | sed 's/msh> //g'
+}
+
+check()
+{
+    if [ "$2" != "$3" ]
+    then
+        echo "FAIL: $1: expected '$3', got '$2'"
+        FAILED=1
+    else
+        echo "ok: $1"
+    fi
+}
+
+# Every command reads its whole input, so no writer is stopped early
+check "last command" "$(run "false | cat" 'echo $? $PIPESTATUS')" "0 1 0"
+check "pipefail" "$(run "set -o pipefail" "false | cat | cat" 'echo $? $PIPESTATUS')" "1 1 0 0"
+check "last failure" "$(run "set -o pipefail" "false | grep -s x /nonexistent | cat" 'echo $?')" "2"
+check "unset" "$(run "set -o pipefail" "set +o pipefail" "false | cat" 'echo $?')" "0"
+check "upstream stopped" "$(run "yes | head -1" 'echo $PIPESTATUS')" "$(printf 'y\n141 0')"
+
+exit $FAILED
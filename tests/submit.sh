@@ -0,0 +1,57 @@
+#!/bin/bash
+
+# Checks that submitted commands run once a slot is free, the highest
+# priority first, and that a script waits for all of them.
+#
+# Usage: tests/submit.sh [path to minishell]
+
+MINISHELL=${1:-./minishell}
+DIRECTORY=$(mktemp -d)
+FAILED=0
+
+trap 'rm -rf "$DIRECTORY"' EXIT
+
+# Runs the given lines and prints the output without prompts, giving up
+# after twenty seconds
+run()
+{
+    printf '%s\n' "$@" | timeout 20 "$MINISHELL" 2>&1 | sed 's/msh> //g'
+}
+
+check()
+{
+    if [ "$2" != "$3" ]
+    then
+        echo "FAIL: $1: expected '$3', got '$2'"
+        FAILED=1
+    else
+        echo "ok: $1"
+    fi
+}
+
+run "submit echo done > $DIRECTORY/done" > /dev/null
+check "waited for" "$(cat "$DIRECTORY/done")" "done"
+
+# The command with the higher priority lists the directory before the other
+# one creates its file
+run "export MSH_QUEUE_SLOTS=1" "submit sleep 0.5" "submit touch $DIRECTORY/low" "submit -p 5 ls $DIRECTORY > $DIRECTORY/high" > /dev/null
+check "priority" "$(grep -c '^low$' "$DIRECTORY/high") $(ls "$DIRECTORY" | grep -c '^low$')" "0 1"
+
+# Every run of the substitution creates a file
+mkdir "$DIRECTORY/runs"
+run "submit echo \$(mktemp -p $DIRECTORY/runs) > $DIRECTORY/once" > /dev/null
+check "substitution run once" "$(ls "$DIRECTORY/runs" | wc -l) $(cat "$DIRECTORY/once")" "1 $(ls -d "$DIRECTORY"/runs/*)"
+
+check "status" "$(run "submit false" "sleep 0.5" "queue" | grep -c 'Done (1)')" "1"
+
+# A list of jobs full of finished ones must not keep the last submission
+# from running once the input ended
+for job in $(seq 49)
+do
+    echo "sleep 0.2 &"
+done > "$DIRECTORY/jobs"
+
+run "$(cat "$DIRECTORY/jobs")" "submit echo late > $DIRECTORY/late" > /dev/null
+check "full list of jobs" "$(cat "$DIRECTORY/late" 2> /dev/null)" "late"
+
+exit $FAILED
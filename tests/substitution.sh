@@ -0,0 +1,42 @@
+#!/bin/bash
+
+# Checks that command substitutions are replaced by the output of their
+# commands, report their status, and never make the shell read its script
+# twice.
+#
+# Usage: tests/substitution.sh [path to minishell]
+
+MINISHELL=${1:-./minishell}
+DIRECTORY=$(mktemp -d)
+FAILED=0
+
+trap 'rm -rf "$DIRECTORY"' EXIT
+
+# Runs the given lines and prints the output without prompts
+run()
+{
+    printf '%s\n' "$@" | "$MINISHELL" 2>&1 | sed 's/msh> //g'
+}
+
+check()
+{
+    if [ "$2" != "$3" ]
+    then
+        echo "FAIL: $1: expected '$3', got '$2'"
+        FAILED=1
+    else
+        echo "ok: $1"
+    fi
+}
+
+check "dollar and backquotes" "$(run 'echo a$(echo b)c `echo d`')" "abc d"
+check "pipeline" "$(run 'echo $(uname -s | tr A-Z a-z)')" "$(uname -s | tr A-Z a-z)"
+check "status" "$(run 'x=$(false)' 'echo $?')" "1"
+check "assignments stay inside" "$(run '$(y=2)' 'echo [$y]')" "[]"
+
+# A script in a regular file shares its offset with the children, which must
+# not rewind it when they exit
+printf '%s\n' 'echo $(uname -s | tr A-Z a-z)' 'echo two' 'echo three' > "$DIRECTORY/script"
+check "script read once" "$("$MINISHELL" < "$DIRECTORY/script" 2>&1 | sed 's/msh> //g' | tail -n +2 | tr '\n' ' ')" "two three "
+
+exit $FAILED
@@ -0,0 +1,35 @@
+#!/bin/bash
+
+# Checks that variables are expanded, and that only exported ones, including
+# the ones imported from the environment, reach the commands.
+#
+# Usage: tests/variables.sh [path to minishell]
+
+MINISHELL=${1:-./minishell}
+FAILED=0
+
+# Runs the given lines and prints the output without prompts
+run()
+{
+    printf '%s\n' "$@" | "$MINISHELL" 2>&1 | sed 's/msh> //g'
+}
+
+check()
+{
+    if [ "$2" != "$3" ]
+    then
+        echo "FAIL: $1: expected '$3', got '$2'"
+        FAILED=1
+    else
+        echo "ok: $1"
+    fi
+}
+
+check "expansion" "$(run "X=one" 'echo $X ${X}two')" "one onetwo"
+check "default values" "$(run "X=one" 'echo ${NONE:-default} ${X:+alternative} ${Y:=assigned} $Y')" "default alternative assigned assigned"
+check "unexported" "$(run "X=one" "env" | grep -c '^X=')" "0"
+check "exported" "$(run "X=one" "export X" "env" | grep '^X=')" "X=one"
+check "unset" "$(run "X=one" "export X" "unset X" 'echo [$X]' "env" | grep -c '^X=\|^\[\]$')" "1"
+check "imported" "$(MSH_TEST_VARIABLE=two run "MSH_TEST_VARIABLE=three" "env" | grep '^MSH_TEST_VARIABLE=')" "MSH_TEST_VARIABLE=three"
+
+exit $FAILED
@@ -0,0 +1,43 @@
+#!/bin/bash
+
+# Checks that commands handed to zygotes run with the working directory,
+# file creation mask and limits set after the zygotes were forked, and take
+# the terminal without being stopped.
+#
+# Usage: tests/zygotes.sh [path to minishell]
+
+MINISHELL=${1:-./minishell}
+DIRECTORY=$(mktemp -d)
+FAILED=0
+
+trap 'rm -rf "$DIRECTORY"' EXIT
+
+# Runs the given lines with zygotes and prints the output without prompts
+run()
+{
+    printf '%s\n' "$@" | MSH_ZYGOTES=2 "$MINISHELL" 2>&1 | sed 's/msh> //g'
+}
+
+check()
+{
+    if [ "$2" != "$3" ]
+    then
+        echo "FAIL: $1: expected '$3', got '$2'"
+        FAILED=1
+    else
+        echo "ok: $1"
+    fi
+}
+
+check "cd then pwd" "$(run "cd $DIRECTORY" pwd)" "$DIRECTORY"
+check "umask then touch" "$(run "cd $DIRECTORY" "umask 077" "touch file" "stat -c %a file" | tail -1)" "600"
+check "ulimit then grep" "$(run "ulimit -n 64" "grep files /proc/self/limits" | awk '{print $4}')" "64"
+
+# Zygotes forked before the shell ignored `SIGTTOU` must not be stopped when
+# they take the terminal, which needs one from `script`
+if command -v script > /dev/null
+then
+    check "terminal without stops" "$(printf '%s\n' true true "ps -o stat=" exit | MSH_ZYGOTES=4 script -qec "$MINISHELL" /dev/null 2>&1 | tr -d '\r' | grep -c '^T')" "0"
+fi
+
+exit $FAILED